@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+# Copyright (c) 2025 Golioth, Inc.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Expand raw QM30VT2 register records into named, scaled fields.
+
+Records streamed with CONFIG_APP_SENSORS_STREAM_RAW=y look like
+
+    {"unit": 1, "ts": 1740000000000, "regs": [512, 1300, 7250, ...]}
+
+and become
+
+    {"ts": 1740000000000, "sensor": {"unit": 1, "temperature": {...}, ...}}
+
+which is what the "sensor" path holds when the device decodes them. The
+register map is read from QM30VT2_METRICS in src/qm30vt2.h, so the device
+and the decoder share one table. Records without "regs" pass through. A
+"metrics" bitmask, sent when a record does not hold every metric, limits
+the fields to the metrics whose bit (QM30VT2_METRICS position) is set.
+
+Serves the webhook transformer of pipelines/raw-to-lightdb.yml:
+
+    qm30vt2_raw_decoder.py --port 8080
+
+or decodes a JSON file for testing:
+
+    qm30vt2_raw_decoder.py --decode records.json
+"""
+
+import argparse
+import json
+import re
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from pathlib import Path
+
+DEFAULT_HEADER = Path(__file__).resolve().parent.parent / "src" / "qm30vt2.h"
+
+X_ENTRY = re.compile(r"\bX\(([^()]*)\)")
+
+
+def load_metrics(header):
+    """Return (reg, decimals, signed, path) for each entry of QM30VT2_METRICS."""
+    text = Path(header).read_text()
+    start = text.index("#define QM30VT2_METRICS(X)")
+    end = text.index("/* clang-format on */", start)
+    body = text[start:end].replace("\\\n", " ")
+
+    metrics = []
+    for entry in X_ENTRY.findall(body):
+        # name, NAME, idx, dec, sgn, qty, label, desc, path...
+        fields = [f.strip() for f in entry.split(",")]
+        reg, decimals, signed = int(fields[2]), int(fields[3]), fields[4] == "true"
+        path = [f.strip('"') for f in fields[8:]]
+        metrics.append((reg, decimals, signed, path))
+
+    if not metrics:
+        raise ValueError(f"No QM30VT2_METRICS entries in {header}")
+
+    return metrics
+
+
+def decode_record(metrics, record):
+    if not isinstance(record, dict) or "regs" not in record:
+        return record
+
+    regs = record["regs"]
+    mask = record.get("metrics", (1 << len(metrics)) - 1)
+    sensor = {"unit": record.get("unit")}
+
+    for bit, (reg, decimals, signed, path) in enumerate(metrics):
+        if not mask & (1 << bit):
+            continue
+
+        raw = regs[reg]
+        if signed and raw >= 0x8000:
+            raw -= 0x10000
+
+        node = sensor
+        for key in path[:-1]:
+            node = node.setdefault(key, {})
+        node[path[-1]] = round(raw / 10**decimals, decimals)
+
+    if "ext" in record:
+        sensor["ext"] = record["ext"]
+
+    out = {"sensor": sensor}
+    if "ts" in record:
+        out = {"ts": record["ts"], **out}
+
+    return out
+
+
+def decode(metrics, data):
+    if isinstance(data, list):
+        return [decode_record(metrics, record) for record in data]
+
+    return decode_record(metrics, data)
+
+
+def serve(metrics, port):
+    class Handler(BaseHTTPRequestHandler):
+        def do_POST(self):
+            length = int(self.headers.get("Content-Length", 0))
+            try:
+                body = json.dumps(decode(metrics, json.loads(self.rfile.read(length))))
+            except (ValueError, KeyError, IndexError, TypeError) as err:
+                self.send_error(400, str(err))
+                return
+
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.end_headers()
+            self.wfile.write(body.encode())
+
+    HTTPServer(("", port), Handler).serve_forever()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--header", default=DEFAULT_HEADER, help="path to qm30vt2.h")
+    mode = parser.add_mutually_exclusive_group(required=True)
+    mode.add_argument("--port", type=int, help="serve the webhook on this port")
+    mode.add_argument("--decode", metavar="FILE", help="decode a JSON file to stdout")
+    args = parser.parse_args()
+
+    metrics = load_metrics(args.header)
+
+    if args.decode:
+        print(json.dumps(decode(metrics, json.loads(Path(args.decode).read_text())), indent=2))
+    else:
+        serve(metrics, args.port)
+
+
+if __name__ == "__main__":
+    main()
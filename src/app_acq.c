@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_acq, LOG_LEVEL_DBG);
+
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/kernel.h>
+#include <zephyr/modbus/modbus.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/slist.h>
+
+#include "app_acq.h"
+#include "app_adaptive.h"
+#include "app_alarm.h"
+#include "app_boot.h"
+#include "app_bus.h"
+#include "app_log.h"
+#include "app_settings.h"
+#include "qm30vt2.h"
+
+#define ZEPHYR_USER_NODE DT_PATH(zephyr_user)
+#define MODBUS_NODE	 DT_COMPAT_GET_ANY_STATUS_OKAY(zephyr_modbus_serial)
+
+/* Bounds the wait for the channel lock and a free message buffer of the upload path */
+#define ACQ_PUB_TIMEOUT K_MSEC(10)
+
+/* Queued transactions, highest priority first; periodic polls come after all of them */
+enum acq_prio {
+	ACQ_PRIO_WRITE,
+	ACQ_PRIO_READ,
+	ACQ_PRIO_COUNT,
+};
+
+enum acq_flag {
+	ACQ_FLAG_POLL_ALL,
+	ACQ_FLAG_PAUSED,
+	ACQ_FLAG_SERIAL_UPDATE,
+	ACQ_FLAG_COUNT,
+};
+
+struct acq_xfer {
+	sys_snode_t node;
+	enum acq_prio prio;
+	uint8_t unit_id;
+	uint16_t addr;
+	uint16_t *regs;
+	uint16_t count;
+	int err;
+	struct k_sem done;
+};
+
+#if DT_NODE_HAS_PROP(ZEPHYR_USER_NODE, rs485_8_click_en_gpios)
+const struct gpio_dt_spec rs485_en = GPIO_DT_SPEC_GET(ZEPHYR_USER_NODE, rs485_8_click_en_gpios);
+#endif
+
+static int client_iface;
+
+/* Defaults until the MODBUS_* settings are applied, see acq_serial_apply() */
+static struct modbus_iface_param client_param = {
+	.mode = MODBUS_MODE_RTU,
+	.rx_timeout = CONFIG_APP_MODBUS_TIMEOUT_MS * USEC_PER_MSEC,
+	/* clang-format off */
+	.serial = {
+		.baud = 19200,
+		.parity = UART_CFG_PARITY_NONE,
+		.stop_bits_client = UART_CFG_STOP_BITS_1,
+	},
+	/* clang-format on */
+};
+
+/* One FIFO per priority, so requests of equal priority are serviced in order */
+static sys_slist_t xfer_queue[ACQ_PRIO_COUNT];
+static struct k_spinlock xfer_lock;
+
+static ATOMIC_DEFINE(acq_flags, ACQ_FLAG_COUNT);
+static K_SEM_DEFINE(acq_wake, 0, 1);
+
+ZBUS_CHAN_DEFINE(app_acq_meas_chan, struct app_acq_meas, NULL, NULL, ZBUS_OBSERVERS_EMPTY,
+		 ZBUS_MSG_INIT(0));
+
+#ifdef CONFIG_ZBUS_MSG_SUBSCRIBER_BUF_ALLOC_STATIC
+BUILD_ASSERT(sizeof(struct app_acq_meas) <= CONFIG_ZBUS_MSG_SUBSCRIBER_NET_BUF_STATIC_DATA_SIZE);
+#endif
+
+#ifdef CONFIG_APP_REGMAP
+ZBUS_CHAN_DEFINE(app_acq_regmap_chan, struct app_regmap_sample, NULL, NULL, ZBUS_OBSERVERS_EMPTY,
+		 ZBUS_MSG_INIT(0));
+
+#ifdef CONFIG_ZBUS_MSG_SUBSCRIBER_BUF_ALLOC_STATIC
+BUILD_ASSERT(sizeof(struct app_regmap_sample) <=
+	     CONFIG_ZBUS_MSG_SUBSCRIBER_NET_BUF_STATIC_DATA_SIZE);
+#endif
+#endif /* CONFIG_APP_REGMAP */
+
+static atomic_t meas_dropped;
+
+/* The response timeout in use was proposed by app_bus_cal_timeout_ms() */
+static bool timeout_calibrated;
+
+static struct acq_xfer *xfer_get(void)
+{
+	sys_snode_t *node = NULL;
+
+	K_SPINLOCK(&xfer_lock) {
+		for (size_t i = 0; (i < ARRAY_SIZE(xfer_queue)) && (node == NULL); i++) {
+			node = sys_slist_get(&xfer_queue[i]);
+		}
+	}
+
+	return node ? CONTAINER_OF(node, struct acq_xfer, node) : NULL;
+}
+
+static void xfer_run(struct acq_xfer *xfer)
+{
+	if (xfer->prio == ACQ_PRIO_WRITE) {
+		xfer->err = modbus_write_holding_regs(client_iface, xfer->unit_id, xfer->addr,
+						      xfer->regs, xfer->count);
+	} else {
+		xfer->err = modbus_read_holding_regs(client_iface, xfer->unit_id, xfer->addr,
+						     xfer->regs, xfer->count);
+	}
+
+	LOG_DBG("Unit %u: %s of %u registers at %u: %d", xfer->unit_id,
+		(xfer->prio == ACQ_PRIO_WRITE) ? "write" : "read", xfer->count, xfer->addr,
+		xfer->err);
+
+	k_sem_give(&xfer->done);
+}
+
+/* Response timeout for the MODBUS_TIMEOUT_MS setting, 0 calibrates it once every unit
+ * has been measured
+ */
+static uint32_t acq_timeout_ms(bool *calibrated)
+{
+	int32_t timeout_ms = get_modbus_timeout_ms();
+	uint32_t cal_ms;
+
+	*calibrated = false;
+
+	if (timeout_ms) {
+		return timeout_ms;
+	}
+
+	if (app_bus_cal_timeout_ms(&cal_ms) == 0) {
+		*calibrated = true;
+		return cal_ms;
+	}
+
+	return CONFIG_APP_MODBUS_TIMEOUT_MS;
+}
+
+/* Re-initialize the client if the MODBUS_* settings or the calibrated timeout changed.
+ * Only this thread uses the client, so no transaction is in flight.
+ */
+static void acq_serial_apply(void)
+{
+	struct modbus_iface_param param = client_param;
+	bool calibrated;
+	int err;
+
+	param.serial.baud = get_modbus_baud();
+	param.serial.parity = get_modbus_parity();
+
+	/* Response times measured at another baud rate or framing no longer apply */
+	if ((param.serial.baud != client_param.serial.baud) ||
+	    (param.serial.parity != client_param.serial.parity)) {
+		app_bus_cal_reset();
+	}
+
+	param.rx_timeout = acq_timeout_ms(&calibrated) * USEC_PER_MSEC;
+	timeout_calibrated = calibrated;
+
+	if ((param.serial.baud == client_param.serial.baud) &&
+	    (param.serial.parity == client_param.serial.parity) &&
+	    (param.rx_timeout == client_param.rx_timeout)) {
+		return;
+	}
+
+	(void)modbus_disable(client_iface);
+
+	err = modbus_init_client(client_iface, param);
+	if (err) {
+		LOG_ERR("Failed to apply Modbus settings: %d", err);
+
+		/* Keep polling with the parameters that worked */
+		err = modbus_init_client(client_iface, client_param);
+		if (err) {
+			LOG_ERR("Modbus RTU client initialization failed: %d", err);
+		}
+		return;
+	}
+
+	client_param = param;
+
+	LOG_INF("Modbus client: %u baud, %s parity, %u ms timeout%s", param.serial.baud,
+		app_settings_parity_name(param.serial.parity), param.rx_timeout / USEC_PER_MSEC,
+		calibrated ? " (calibrated)" : "");
+}
+
+/* Record the result of a poll and follow the calibrated timeout. Once applied, the
+ * calibrated timeout is kept until calibration starts over: when a unit times out or
+ * the unit list changes.
+ */
+static void acq_poll_done(struct app_bus_unit *unit, int err, uint32_t poll_start)
+{
+	bool restart;
+
+	app_bus_poll_done(unit, err, k_cyc_to_us_floor32(k_cycle_get_32() - poll_start));
+
+	if (get_modbus_timeout_ms()) {
+		return;
+	}
+
+	restart = app_bus_units_changed();
+
+	/* A unit slower than measured, rather than one that stopped answering */
+	if (timeout_calibrated && (err == -ETIMEDOUT) &&
+	    (unit->health != APP_BUS_HEALTH_QUARANTINED)) {
+		LOG_WRN("Unit %u timed out after %u ms, recalibrating", unit->cfg.id,
+			client_param.rx_timeout / USEC_PER_MSEC);
+		app_bus_cal_reset();
+		restart = true;
+	}
+
+	/* While calibrating, only successful polls can complete the measurement */
+	if (!restart && (timeout_calibrated || err)) {
+		return;
+	}
+
+	acq_serial_apply();
+}
+
+#ifdef CONFIG_APP_REGMAP
+static void acq_poll_regmap(struct app_bus_unit *unit)
+{
+	struct app_regmap_sample msg = {
+		.unit_id = unit->cfg.id,
+	};
+	uint32_t poll_start;
+	int err;
+
+	APP_LOG_INF_RL("Reading register map from unit %u", unit->cfg.id);
+
+	app_bus_poll_start(unit);
+	poll_start = k_cycle_get_32();
+	err = app_regmap_read(client_iface, unit->cfg.id, &msg);
+	acq_poll_done(unit, err, poll_start);
+	msg.uptime_ms = k_uptime_get();
+
+	if (err) {
+		APP_LOG_ERR_RL("Failed to read register map from unit %u: %d", unit->cfg.id, err);
+		return;
+	}
+	app_boot_mark(APP_BOOT_FIRST_SAMPLE);
+
+	err = zbus_chan_pub(&app_acq_regmap_chan, &msg, ACQ_PUB_TIMEOUT);
+	if (err) {
+		atomic_inc(&meas_dropped);
+		APP_LOG_WRN_RL("Sample of unit %u not delivered to every sink: %d", unit->cfg.id,
+			       err);
+	}
+}
+#endif /* CONFIG_APP_REGMAP */
+
+static void acq_poll(struct app_bus_unit *unit)
+{
+	struct app_acq_meas msg = {
+		.unit_id = unit->cfg.id,
+		.metrics = get_metric_mask(),
+	};
+	uint32_t read_mask;
+	uint32_t poll_start;
+	int err;
+
+	/* Masked metrics would read as 0 and clear alarms or relax the poll period */
+	read_mask = msg.metrics | app_alarm_metrics() |
+		    ((unit->cfg.period_s == 0) ? app_adaptive_metrics() : 0);
+
+	APP_LOG_INF_RL("Reading temperature & vibration data from QM30VT2 unit %u", unit->cfg.id);
+
+	app_bus_poll_start(unit);
+	poll_start = k_cycle_get_32();
+	err = qm30vt2_read_regs(client_iface, unit->cfg.id, msg.holding_reg, read_mask,
+				&msg.meas);
+	acq_poll_done(unit, err, poll_start);
+	msg.uptime_ms = k_uptime_get();
+
+	if (!err) {
+		err = qm30vt2_decode(msg.holding_reg, &msg.meas, read_mask);
+	}
+	if (err) {
+		APP_LOG_ERR_RL("Failed to read QM30VT2 unit %u values: %d", unit->cfg.id, err);
+		return;
+	}
+	app_boot_mark(APP_BOOT_FIRST_SAMPLE);
+
+	/* Observers never block the bus; a sink that cannot keep up loses the sample */
+	err = zbus_chan_pub(&app_acq_meas_chan, &msg, ACQ_PUB_TIMEOUT);
+	if (err) {
+		atomic_inc(&meas_dropped);
+		APP_LOG_WRN_RL("Sample of unit %u not delivered to every sink: %d", unit->cfg.id,
+			       err);
+	}
+}
+
+static void acq_thread_fn(void *p1, void *p2, void *p3)
+{
+	while (true) {
+		struct acq_xfer *xfer = xfer_get();
+		struct app_bus_unit *unit = NULL;
+		bool paused = atomic_test_bit(acq_flags, ACQ_FLAG_PAUSED);
+
+		if (atomic_test_and_clear_bit(acq_flags, ACQ_FLAG_POLL_ALL)) {
+			app_bus_poll_all();
+		}
+
+		if (atomic_test_and_clear_bit(acq_flags, ACQ_FLAG_SERIAL_UPDATE)) {
+			acq_serial_apply();
+		}
+
+		if (xfer) {
+			xfer_run(xfer);
+			continue;
+		}
+
+		/* Due units are polled back to back, checking for requests in between */
+		if (!paused) {
+			unit = app_bus_next_due(k_uptime_get());
+		}
+		if (unit) {
+#ifdef CONFIG_APP_REGMAP
+			if (unit->cfg.regmap) {
+				acq_poll_regmap(unit);
+				continue;
+			}
+#endif
+			acq_poll(unit);
+			continue;
+		}
+
+		k_sem_take(&acq_wake,
+			   paused ? K_FOREVER : K_TIMEOUT_ABS_MS(app_bus_next_poll_ms()));
+	}
+}
+
+K_THREAD_DEFINE(acq_thread, CONFIG_APP_ACQ_STACK_SIZE, acq_thread_fn, NULL, NULL, NULL,
+		CONFIG_APP_ACQ_THREAD_PRIORITY, 0, K_TICKS_FOREVER);
+
+static int xfer_submit(struct acq_xfer *xfer, k_timeout_t timeout)
+{
+	bool queued = false;
+
+	k_sem_init(&xfer->done, 0, 1);
+
+	K_SPINLOCK(&xfer_lock) {
+		sys_slist_append(&xfer_queue[xfer->prio], &xfer->node);
+	}
+	k_sem_give(&acq_wake);
+
+	if (k_sem_take(&xfer->done, timeout) == 0) {
+		return xfer->err;
+	}
+
+	K_SPINLOCK(&xfer_lock) {
+		queued = sys_slist_find_and_remove(&xfer_queue[xfer->prio], &xfer->node);
+	}
+	if (queued) {
+		return -EAGAIN;
+	}
+
+	/* Already on the bus, the Modbus rx_timeout bounds the wait */
+	k_sem_take(&xfer->done, K_FOREVER);
+
+	return xfer->err;
+}
+
+int app_acq_read(uint8_t unit_id, uint16_t addr, uint16_t *regs, uint16_t count,
+		 k_timeout_t timeout)
+{
+	struct acq_xfer xfer = {
+		.prio = ACQ_PRIO_READ,
+		.unit_id = unit_id,
+		.addr = addr,
+		.regs = regs,
+		.count = count,
+	};
+
+	return xfer_submit(&xfer, timeout);
+}
+
+int app_acq_write(uint8_t unit_id, uint16_t addr, uint16_t *regs, uint16_t count,
+		  k_timeout_t timeout)
+{
+	struct acq_xfer xfer = {
+		.prio = ACQ_PRIO_WRITE,
+		.unit_id = unit_id,
+		.addr = addr,
+		.regs = regs,
+		.count = count,
+	};
+
+	return xfer_submit(&xfer, timeout);
+}
+
+void app_acq_poll_all(void)
+{
+	atomic_set_bit(acq_flags, ACQ_FLAG_POLL_ALL);
+	k_sem_give(&acq_wake);
+}
+
+void app_acq_polling_set(bool enabled)
+{
+	if (enabled) {
+		atomic_clear_bit(acq_flags, ACQ_FLAG_PAUSED);
+	} else {
+		atomic_set_bit(acq_flags, ACQ_FLAG_PAUSED);
+	}
+	k_sem_give(&acq_wake);
+}
+
+void app_acq_serial_update(void)
+{
+	atomic_set_bit(acq_flags, ACQ_FLAG_SERIAL_UPDATE);
+	k_sem_give(&acq_wake);
+}
+
+uint32_t app_acq_timeout_ms(void)
+{
+	return client_param.rx_timeout / USEC_PER_MSEC;
+}
+
+uint32_t app_acq_meas_dropped(void)
+{
+	return atomic_get(&meas_dropped);
+}
+
+int app_acq_init(void)
+{
+	const char iface_name[] = {DEVICE_DT_NAME(MODBUS_NODE)};
+	int err;
+
+#if DT_NODE_HAS_PROP(ZEPHYR_USER_NODE, rs485_8_click_en_gpios)
+	/* Set the RS-485 transceiver EN signal */
+	if (gpio_pin_configure_dt(&rs485_en, GPIO_OUTPUT_ACTIVE)) {
+		LOG_ERR("RS-485 transceiver enable pin configuration failed");
+	}
+#endif
+
+	/* Polls go on without the extended registers if their list is invalid */
+	(void)qm30vt2_init();
+
+	client_iface = modbus_iface_get_by_name(iface_name);
+
+	err = modbus_init_client(client_iface, client_param);
+	if (err) {
+		LOG_ERR("Modbus RTU client initialization failed: %d", err);
+	}
+
+	/* Started regardless, so failed polls show up in the bus statistics. Periodic
+	 * polls wait for the main loop, queued requests are serviced right away.
+	 */
+	atomic_set_bit(acq_flags, ACQ_FLAG_PAUSED);
+	k_thread_start(acq_thread);
+
+	return err;
+}
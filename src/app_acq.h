@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_ACQ_H__
+#define __APP_ACQ_H__
+
+/** Modbus acquisition thread.
+ *
+ * A dedicated thread owns the Modbus client interface; nothing else touches
+ * the RS-485 bus. It services a priority queue of transactions, from highest
+ * to lowest priority:
+ *
+ * - register writes, e.g. sensor configuration (app_acq_write());
+ * - on-demand reads, e.g. from the `read_registers` RPC (app_acq_read());
+ * - periodic polls of the units scheduled by app_bus.h.
+ *
+ * Transactions do not preempt each other, so a queued request waits at most
+ * for the one on the bus. How late each poll starts against its deadline is
+ * recorded as poll jitter, see app_bus_poll_start().
+ *
+ * A poll only reads the span of registers that holds the metrics selected with
+ * the `METRICS_MASK` setting, and only decodes those metrics.
+ *
+ * Each successful poll is decoded and published once on the app_acq_meas_chan
+ * zbus channel. Sinks observe the channel independently and never delay a
+ * poll:
+ *
+ * - the cloud path in app_sensors.c is a message subscriber that processes
+ *   every sample (alarms, report-by-exception, batching and upload);
+ * - the measurement log is a listener;
+ * - the Ostentus display (app_display.h) is a listener that schedules a
+ *   rate-limited refresh from the latest message, dropping stale samples.
+ *
+ * Units polled with the generic register map (app_regmap.h) are published on
+ * app_acq_regmap_chan instead, which only the cloud path observes.
+ *
+ * The baud rate, parity and response timeout of the client follow the
+ * `MODBUS_*` settings (app_settings.h). When they change, the thread disables
+ * and re-initializes the client between two transactions. With
+ * `MODBUS_TIMEOUT_MS` set to 0, the timeout is calibrated from the duration of
+ * successful polls (see app_bus_cal_timeout_ms()) once every unit that is not
+ * quarantined has been measured. When a unit that is not quarantined times
+ * out, it falls back to `CONFIG_APP_MODBUS_TIMEOUT_MS` for a new calibration.
+ *
+ * Further sinks add themselves with ZBUS_CHAN_ADD_OBS(). Listeners run in the
+ * acquisition thread and must return quickly. A sample that cannot be handed to
+ * every observer, e.g. because the cloud path fell behind and its message pool
+ * is exhausted, is counted as dropped.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "qm30vt2.h"
+#ifdef CONFIG_APP_REGMAP
+#include "app_regmap.h"
+#endif
+
+/* Message of app_acq_meas_chan */
+struct app_acq_meas {
+	uint8_t unit_id;
+	/* k_uptime_get() when the poll completed */
+	int64_t uptime_ms;
+	/* Metrics to report, see get_metric_mask(). meas also holds the metrics alarm
+	 * rules and adaptive polling need; the others are cleared.
+	 */
+	uint32_t metrics;
+	uint16_t holding_reg[QM30VT2_ALIAS_SIZE];
+	struct qm30vt2_measurement meas;
+};
+
+ZBUS_CHAN_DECLARE(app_acq_meas_chan);
+
+#ifdef CONFIG_APP_REGMAP
+/* Message is struct app_regmap_sample */
+ZBUS_CHAN_DECLARE(app_acq_regmap_chan);
+#endif
+
+/**
+ * Set up the RS-485 transceiver and Modbus client, then start the thread with
+ * periodic polls paused until app_acq_polling_set() enables them.
+ */
+int app_acq_init(void);
+
+/**
+ * Make every unit due immediately (button press or settings change). Can be
+ * called from an ISR.
+ */
+void app_acq_poll_all(void);
+
+/** Pause or resume periodic polls; queued reads and writes are still serviced. */
+void app_acq_polling_set(bool enabled);
+
+/** Apply new MODBUS_* settings from the acquisition thread. */
+void app_acq_serial_update(void);
+
+/** Modbus response timeout in use, in milliseconds. */
+uint32_t app_acq_timeout_ms(void);
+
+/** Samples that could not be delivered to every observer of app_acq_meas_chan. */
+uint32_t app_acq_meas_dropped(void);
+
+/**
+ * Read holding registers ahead of pending polls and wait for the result.
+ *
+ * @return 0 on success, -EAGAIN if the request was not started within the
+ * timeout, otherwise the error of the Modbus client.
+ */
+int app_acq_read(uint8_t unit_id, uint16_t addr, uint16_t *regs, uint16_t count,
+		 k_timeout_t timeout);
+
+/** Write holding registers ahead of pending reads and polls, see app_acq_read(). */
+int app_acq_write(uint8_t unit_id, uint16_t addr, uint16_t *regs, uint16_t count,
+		  k_timeout_t timeout);
+
+#endif /* __APP_ACQ_H__ */
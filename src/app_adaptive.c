@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_adaptive, LOG_LEVEL_DBG);
+
+#include <zephyr/kernel.h>
+
+#include "app_adaptive.h"
+#include "app_fixed.h"
+#include "app_settings.h"
+
+/* ISO 10816 zone C, "unsatisfactory for long-term operation" */
+#define ADAPTIVE_FAST_ZONE 2
+
+bool app_adaptive_enabled(void)
+{
+	return get_adaptive_min_period_s() != 0;
+}
+
+uint32_t app_adaptive_metrics(void)
+{
+	if (!app_adaptive_enabled()) {
+		return 0;
+	}
+
+	return BIT(QM30VT2_METRIC_X_VEL_RMS_MM) | BIT(QM30VT2_METRIC_Z_VEL_RMS_MM) |
+	       BIT(QM30VT2_METRIC_X_ACC_RMS_HF) | BIT(QM30VT2_METRIC_Z_ACC_RMS_HF);
+}
+
+/* True if value moved from prev by more than both the relative and the absolute threshold */
+static bool adaptive_changed(float value, float prev, float floor)
+{
+	float delta = value > prev ? value - prev : prev - value;
+
+	return (delta > floor) && (delta * 100 > prev * get_adaptive_change_pct());
+}
+
+uint32_t app_adaptive_update(struct app_adaptive_state *state,
+			     const struct app_alarm_state *alarm,
+			     const struct qm30vt2_measurement *meas)
+{
+	uint32_t min_s = get_adaptive_min_period_s();
+	uint32_t max_s = MAX(get_adaptive_max_period_s(), min_s);
+	uint32_t period_s = state->period_s ? state->period_s : max_s;
+	float vel = MAX(qm30vt2_metric_float(meas, QM30VT2_METRIC_X_VEL_RMS_MM),
+			qm30vt2_metric_float(meas, QM30VT2_METRIC_Z_VEL_RMS_MM));
+	float hf = MAX(qm30vt2_metric_float(meas, QM30VT2_METRIC_X_ACC_RMS_HF),
+		       qm30vt2_metric_float(meas, QM30VT2_METRIC_Z_ACC_RMS_HF));
+	bool first = (state->period_s == 0);
+
+	if ((alarm->level[APP_ALARM_VELOCITY] >= ADAPTIVE_FAST_ZONE) ||
+	    alarm->level[APP_ALARM_HF_RMS]) {
+		period_s = min_s;
+	} else if (!first && (adaptive_changed(vel, state->vel, get_rbe_deadband(APP_DEADBAND_VEL)) ||
+			      adaptive_changed(hf, state->hf, get_rbe_deadband(APP_DEADBAND_ACC)))) {
+		period_s /= get_adaptive_speedup_factor();
+	} else {
+		/* Grow by at least a second so short periods relax too */
+		period_s += MAX(period_s * get_adaptive_relax_pct() / 100, 1);
+	}
+
+	period_s = CLAMP(period_s, min_s, max_s);
+
+	if (!first && (period_s != state->period_s)) {
+		char vel_str[APP_FIXED_STR_LEN];
+		char hf_str[APP_FIXED_STR_LEN];
+
+		app_fixed_format(vel_str, sizeof(vel_str), app_fixed_from_float(vel, 3), 3);
+		app_fixed_format(hf_str, sizeof(hf_str), app_fixed_from_float(hf, 3), 3);
+		LOG_DBG("Poll period %u -> %u s (velocity %s mm/s, HF RMS %s G)", state->period_s,
+			period_s, vel_str, hf_str);
+	}
+
+	state->period_s = period_s;
+	state->vel = vel;
+	state->hf = hf;
+
+	return period_s;
+}
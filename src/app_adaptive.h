@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_ADAPTIVE_H__
+#define __APP_ADAPTIVE_H__
+
+/** Adaptive poll period driven by vibration severity.
+ *
+ * When `ADAPTIVE_MIN_PERIOD_S` is non-zero, units without a fixed poll period
+ * are polled at a period that follows the machine condition:
+ *
+ *  - velocity in ISO 10816 zone C or D, or a high-frequency RMS alarm, polls at
+ *    the minimum period straight away;
+ *  - overall RMS velocity or HF RMS acceleration moving by more than
+ *    `ADAPTIVE_CHANGE_PCT` percent (and more than the matching `RBE_*_DEADBAND`)
+ *    since the previous poll divides the period by `ADAPTIVE_SPEEDUP_FACTOR`;
+ *  - otherwise the period grows by `ADAPTIVE_RELAX_PCT` percent per poll back
+ *    towards the `ADAPTIVE_MAX_PERIOD_S` baseline.
+ */
+
+#include <stdint.h>
+
+#include "app_alarm.h"
+#include "qm30vt2.h"
+
+struct app_adaptive_state {
+	/* Current period in seconds, 0 until the first update */
+	uint32_t period_s;
+	/* Overall RMS velocity (mm/s) and HF RMS acceleration (G) at the previous poll */
+	float vel;
+	float hf;
+};
+
+/** Whether adaptive sampling is enabled by the settings. */
+bool app_adaptive_enabled(void);
+
+/**
+ * Metrics the poll period follows, 0 if adaptive sampling is disabled. They are
+ * read on every poll of a unit without a fixed period, whether or not
+ * `METRICS_MASK` reports them.
+ */
+uint32_t app_adaptive_metrics(void);
+
+/**
+ * Update the poll period of a unit from a new measurement and its alarm levels.
+ *
+ * @return new period in seconds
+ */
+uint32_t app_adaptive_update(struct app_adaptive_state *state,
+			     const struct app_alarm_state *alarm,
+			     const struct qm30vt2_measurement *meas);
+
+#endif /* __APP_ADAPTIVE_H__ */
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_alarm, LOG_LEVEL_DBG);
+
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+
+#include "app_alarm.h"
+#include "app_bus.h"
+#include "app_fixed.h"
+#include "app_settings.h"
+#include "app_time.h"
+
+#define ALARM_STREAM_PATH  "alarm"
+#define ALARM_PAYLOAD_SIZE 160
+
+/* Enough for the register resolution of every rule's metric */
+#define ALARM_VALUE_DECIMALS 3
+
+/* Most levels of any rule, i.e. ISO 10816 zones A to D */
+#define ALARM_MAX_LIMITS 3
+
+/* An event in flight is identified to its completion callback by unit, rule and level */
+#define ALARM_EVENT_ARG(unit_id, rule, level)                                                      \
+	((void *)(uintptr_t)((unit_id) | ((rule) << 8) | ((level) << 16)))
+#define ALARM_EVENT_UNIT(arg)  ((uint8_t)(uintptr_t)(arg))
+#define ALARM_EVENT_RULE(arg)  ((uint8_t)((uintptr_t)(arg) >> 8))
+#define ALARM_EVENT_LEVEL(arg) ((uint8_t)((uintptr_t)(arg) >> 16))
+
+/* ISO 10816-1 RMS velocity zone boundaries A/B, B/C and C/D in mm/s */
+static const float iso10816_zones[][ALARM_MAX_LIMITS] = {
+	{0.71f, 1.8f, 4.5f},  /* Class I: small machines, up to 15 kW */
+	{1.12f, 2.8f, 7.1f},  /* Class II: medium machines, 15 kW to 75 kW */
+	{1.8f, 4.5f, 11.2f},  /* Class III: large machines, rigid foundations */
+	{2.8f, 7.1f, 18.0f},  /* Class IV: large machines, soft foundations */
+};
+
+static const char *const rule_names[APP_ALARM_RULE_COUNT] = {
+	[APP_ALARM_VELOCITY] = "velocity",
+	[APP_ALARM_KURTOSIS] = "kurtosis",
+	[APP_ALARM_CREST_FACTOR] = "crest_factor",
+	[APP_ALARM_HF_RMS] = "high_frequency_rms",
+	[APP_ALARM_TEMP] = "temperature",
+};
+
+static const char *const zone_names[] = {"A", "B", "C", "D"};
+static const char *const threshold_names[] = {"normal", "alarm"};
+
+static const char *alarm_level_name(enum app_alarm_rule rule, uint8_t level)
+{
+	return (rule == APP_ALARM_VELOCITY) ? zone_names[level] : threshold_names[level];
+}
+
+static double alarm_value(enum app_alarm_rule rule, const struct qm30vt2_measurement *meas)
+{
+	switch (rule) {
+	case APP_ALARM_VELOCITY:
+		return MAX(qm30vt2_metric_float(meas, QM30VT2_METRIC_X_VEL_RMS_MM),
+			   qm30vt2_metric_float(meas, QM30VT2_METRIC_Z_VEL_RMS_MM));
+	case APP_ALARM_KURTOSIS:
+		return MAX(qm30vt2_metric_float(meas, QM30VT2_METRIC_X_ACC_KURT),
+			   qm30vt2_metric_float(meas, QM30VT2_METRIC_Z_ACC_KURT));
+	case APP_ALARM_CREST_FACTOR:
+		return MAX(qm30vt2_metric_float(meas, QM30VT2_METRIC_X_ACC_CF),
+			   qm30vt2_metric_float(meas, QM30VT2_METRIC_Z_ACC_CF));
+	case APP_ALARM_HF_RMS:
+		return MAX(qm30vt2_metric_float(meas, QM30VT2_METRIC_X_ACC_RMS_HF),
+			   qm30vt2_metric_float(meas, QM30VT2_METRIC_Z_ACC_RMS_HF));
+	case APP_ALARM_TEMP:
+	default:
+		return qm30vt2_metric_float(meas, QM30VT2_METRIC_TEMP_C);
+	}
+}
+
+/* Metrics each rule is evaluated on, see alarm_value() */
+static const uint32_t rule_metrics[APP_ALARM_RULE_COUNT] = {
+	[APP_ALARM_VELOCITY] = BIT(QM30VT2_METRIC_X_VEL_RMS_MM) | BIT(QM30VT2_METRIC_Z_VEL_RMS_MM),
+	[APP_ALARM_KURTOSIS] = BIT(QM30VT2_METRIC_X_ACC_KURT) | BIT(QM30VT2_METRIC_Z_ACC_KURT),
+	[APP_ALARM_CREST_FACTOR] = BIT(QM30VT2_METRIC_X_ACC_CF) | BIT(QM30VT2_METRIC_Z_ACC_CF),
+	[APP_ALARM_HF_RMS] = BIT(QM30VT2_METRIC_X_ACC_RMS_HF) | BIT(QM30VT2_METRIC_Z_ACC_RMS_HF),
+	[APP_ALARM_TEMP] = BIT(QM30VT2_METRIC_TEMP_C),
+};
+
+/* Fill in the ascending level boundaries of a rule and return how many there are */
+static size_t alarm_limits(enum app_alarm_rule rule, float limits[ALARM_MAX_LIMITS])
+{
+	static const enum app_alarm_limit rule_limits[APP_ALARM_RULE_COUNT] = {
+		[APP_ALARM_KURTOSIS] = APP_ALARM_LIMIT_KURTOSIS,
+		[APP_ALARM_CREST_FACTOR] = APP_ALARM_LIMIT_CREST_FACTOR,
+		[APP_ALARM_HF_RMS] = APP_ALARM_LIMIT_HF_RMS,
+		[APP_ALARM_TEMP] = APP_ALARM_LIMIT_TEMP,
+	};
+
+	if (rule == APP_ALARM_VELOCITY) {
+		memcpy(limits, iso10816_zones[get_alarm_machine_class() - 1],
+		       sizeof(iso10816_zones[0]));
+		return ALARM_MAX_LIMITS;
+	}
+
+	limits[0] = get_alarm_limit(rule_limits[rule]);
+
+	return (limits[0] > 0.0f) ? 1 : 0;
+}
+
+uint32_t app_alarm_metrics(void)
+{
+	float limits[ALARM_MAX_LIMITS];
+	uint32_t mask = 0;
+
+	for (int rule = 0; rule < APP_ALARM_RULE_COUNT; rule++) {
+		if (alarm_limits(rule, limits)) {
+			mask |= rule_metrics[rule];
+		}
+	}
+
+	return mask;
+}
+
+/* Level of a rule that has neither been acknowledged nor is being sent */
+static bool alarm_unsent(const struct app_alarm_state *state, int rule)
+{
+	return (state->level[rule] != state->reported[rule]) &&
+	       (state->inflight[rule] != state->level[rule] + 1);
+}
+
+bool app_alarm_evaluate(struct app_alarm_state *state, uint8_t unit_id,
+			const struct qm30vt2_measurement *meas)
+{
+	float hysteresis = 1.0f - get_alarm_hysteresis_pct() / 100.0f;
+	float limits[ALARM_MAX_LIMITS];
+	char vbuf[APP_FIXED_STR_LEN];
+	bool changed = false;
+
+	for (int rule = 0; rule < APP_ALARM_RULE_COUNT; rule++) {
+		size_t count = alarm_limits(rule, limits);
+		double value = alarm_value(rule, meas);
+		uint8_t level = MIN(state->level[rule], count);
+
+		while ((level < count) && (value > limits[level])) {
+			level++;
+		}
+		while ((level > 0) && (value < limits[level - 1] * hysteresis)) {
+			level--;
+		}
+
+		if (level != state->level[rule]) {
+			app_fixed_format(vbuf, sizeof(vbuf),
+					 app_fixed_from_float(value, ALARM_VALUE_DECIMALS),
+					 ALARM_VALUE_DECIMALS);
+		}
+
+		if (level > state->level[rule]) {
+			LOG_WRN("Unit %u %s alarm: %s -> %s (%s)", unit_id, rule_names[rule],
+				alarm_level_name(rule, state->level[rule]),
+				alarm_level_name(rule, level), vbuf);
+		} else if (level < state->level[rule]) {
+			LOG_INF("Unit %u %s alarm cleared: %s -> %s (%s)", unit_id, rule_names[rule],
+				alarm_level_name(rule, state->level[rule]),
+				alarm_level_name(rule, level), vbuf);
+		}
+
+		state->level[rule] = level;
+		changed = changed || alarm_unsent(state, rule);
+	}
+
+	return changed;
+}
+
+/* Settle an event of a unit, which may have been removed while it was in flight */
+static void alarm_event_done(uint8_t unit_id, uint8_t rule, uint8_t level, bool acked)
+{
+	struct app_bus_unit *unit = app_bus_unit_lock(unit_id);
+
+	if (!unit) {
+		return;
+	}
+
+	if (unit->alarm.inflight[rule] == level + 1) {
+		unit->alarm.inflight[rule] = 0;
+	}
+	if (acked) {
+		unit->alarm.reported[rule] = level;
+	}
+
+	app_bus_unit_unlock();
+}
+
+static void alarm_stream_handler(struct golioth_client *client, enum golioth_status status,
+				 const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
+				 void *arg)
+{
+	if (status != GOLIOTH_OK) {
+		LOG_ERR("Failed to send alarm event: %d", status);
+	}
+
+	alarm_event_done(ALARM_EVENT_UNIT(arg), ALARM_EVENT_RULE(arg), ALARM_EVENT_LEVEL(arg),
+			 status == GOLIOTH_OK);
+}
+
+#ifdef CONFIG_APP_SENSORS_STREAM_FORMAT_JSON
+#define ALARM_CONTENT_TYPE GOLIOTH_CONTENT_TYPE_JSON
+
+static int alarm_event_encode(uint8_t *buf, size_t buf_len, uint8_t unit_id, int64_t ts_ms,
+			      enum app_alarm_rule rule, uint8_t level, uint8_t prev, double value)
+{
+	char ts[24] = "";
+	char vbuf[APP_FIXED_STR_LEN];
+	int len;
+
+	if (ts_ms) {
+		snprintk(ts, sizeof(ts), "\"ts\":%lld,", (long long)ts_ms);
+	}
+
+	app_fixed_format(vbuf, sizeof(vbuf), app_fixed_from_float(value, ALARM_VALUE_DECIMALS),
+			 ALARM_VALUE_DECIMALS);
+
+	len = snprintk((char *)buf, buf_len,
+		       "[{\"unit\":%u,%s\"rule\":\"%s\",\"level\":\"%s\",\"prev\":\"%s\","
+		       "\"value\":%s}]",
+		       unit_id, ts, rule_names[rule], alarm_level_name(rule, level),
+		       alarm_level_name(rule, prev), vbuf);
+	if ((len < 0) || (len >= buf_len)) {
+		return -ENOMEM;
+	}
+
+	return len;
+}
+#else
+#define ALARM_CONTENT_TYPE GOLIOTH_CONTENT_TYPE_CBOR
+
+static int alarm_event_encode(uint8_t *buf, size_t buf_len, uint8_t unit_id, int64_t ts_ms,
+			      enum app_alarm_rule rule, uint8_t level, uint8_t prev, double value)
+{
+	const char *rule_name = rule_names[rule];
+	const char *level_name = alarm_level_name(rule, level);
+	const char *prev_name = alarm_level_name(rule, prev);
+	bool ok;
+
+	ZCBOR_STATE_E(zse, 2, buf, buf_len, 1);
+
+	/* A list of one record, like the sensor path */
+	ok = zcbor_list_start_encode(zse, 1) && zcbor_map_start_encode(zse, 6) &&
+	     zcbor_tstr_put_lit(zse, "unit") && zcbor_uint32_put(zse, unit_id);
+
+	if (ok && ts_ms) {
+		ok = zcbor_tstr_put_lit(zse, "ts") && zcbor_int64_put(zse, ts_ms);
+	}
+
+	ok = ok && zcbor_tstr_put_lit(zse, "rule") &&
+	     zcbor_tstr_encode_ptr(zse, rule_name, strlen(rule_name)) &&
+	     zcbor_tstr_put_lit(zse, "level") &&
+	     zcbor_tstr_encode_ptr(zse, level_name, strlen(level_name)) &&
+	     zcbor_tstr_put_lit(zse, "prev") &&
+	     zcbor_tstr_encode_ptr(zse, prev_name, strlen(prev_name)) &&
+	     zcbor_tstr_put_lit(zse, "value") && zcbor_float64_put(zse, value) &&
+	     zcbor_map_end_encode(zse, 6) && zcbor_list_end_encode(zse, 1);
+	if (!ok) {
+		return -ENOMEM;
+	}
+
+	return zse->payload - buf;
+}
+#endif /* CONFIG_APP_SENSORS_STREAM_FORMAT_JSON */
+
+size_t app_alarm_take(struct app_alarm_state *state, uint8_t unit_id,
+		      struct app_alarm_events *events)
+{
+	events->unit_id = unit_id;
+	events->count = 0;
+
+	for (int rule = 0; rule < APP_ALARM_RULE_COUNT; rule++) {
+		if (!alarm_unsent(state, rule)) {
+			continue;
+		}
+
+		events->event[events->count].rule = rule;
+		events->event[events->count].level = state->level[rule];
+		events->event[events->count].prev = state->reported[rule];
+		events->count++;
+
+		state->inflight[rule] = state->level[rule] + 1;
+	}
+
+	return events->count;
+}
+
+int app_alarm_report(struct golioth_client *client, const struct app_alarm_events *events,
+		     const struct qm30vt2_measurement *meas)
+{
+	uint8_t buf[ALARM_PAYLOAD_SIZE];
+	int64_t ts_ms = 0;
+	size_t i;
+	int len;
+	int err = 0;
+
+	if (app_time_unix_offset_ms(&ts_ms) == 0) {
+		ts_ms += k_uptime_get();
+	}
+
+	for (i = 0; i < events->count; i++) {
+		uint8_t rule = events->event[i].rule;
+		uint8_t level = events->event[i].level;
+
+		len = alarm_event_encode(buf, sizeof(buf), events->unit_id, ts_ms, rule, level,
+					 events->event[i].prev, alarm_value(rule, meas));
+		if (len < 0) {
+			LOG_ERR("Failed to encode alarm event: %d", len);
+			err = len;
+			break;
+		}
+
+		err = golioth_stream_set_async(client,
+					       ALARM_STREAM_PATH,
+					       ALARM_CONTENT_TYPE,
+					       buf,
+					       len,
+					       alarm_stream_handler,
+					       ALARM_EVENT_ARG(events->unit_id, rule, level));
+		if (err) {
+			LOG_ERR("Failed to send alarm event: %d", err);
+			break;
+		}
+	}
+
+	/* Events that were not queued are sent again after the next evaluation */
+	for (size_t j = i; j < events->count; j++) {
+		alarm_event_done(events->unit_id, events->event[j].rule, events->event[j].level,
+				 false);
+	}
+
+	return err ? err : (int)i;
+}
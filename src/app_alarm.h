@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_ALARM_H__
+#define __APP_ALARM_H__
+
+/** On-device alarm rules evaluated on every fresh measurement.
+ *
+ * The overall RMS velocity (the larger of the X and Z axes, in mm/s) is
+ * classified into the ISO 10816 severity zones A to D for the machine class set
+ * with `ALARM_MACHINE_CLASS`. Kurtosis, crest factor, high-frequency RMS
+ * acceleration and temperature each have a single alarm threshold set with the
+ * `ALARM_*` settings; a threshold of 0 disables the rule.
+ *
+ * A level is raised as soon as the value exceeds a boundary and only lowered
+ * once it drops `ALARM_HYSTERESIS_PCT` percent below that boundary, so a value
+ * hovering around a threshold does not generate a stream of events.
+ *
+ * Each level change is sent to the `alarm` LightDB Stream path straight away,
+ * without waiting for the sample batch. Changes that happen while the client is
+ * disconnected are sent on the first poll after reconnecting.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <golioth/client.h>
+
+#include "qm30vt2.h"
+
+enum app_alarm_rule {
+	APP_ALARM_VELOCITY,
+	APP_ALARM_KURTOSIS,
+	APP_ALARM_CREST_FACTOR,
+	APP_ALARM_HF_RMS,
+	APP_ALARM_TEMP,
+	APP_ALARM_RULE_COUNT,
+};
+
+struct app_alarm_state {
+	/* Current level of each rule: zone A..D as 0..3 for velocity, 0 or 1 otherwise */
+	uint8_t level[APP_ALARM_RULE_COUNT];
+	/* Level last acknowledged by the cloud */
+	uint8_t reported[APP_ALARM_RULE_COUNT];
+	/* Level of the event being sent plus one, 0 if none */
+	uint8_t inflight[APP_ALARM_RULE_COUNT];
+};
+
+/**
+ * Metrics the enabled rules are evaluated on. They are read on every poll,
+ * whether or not `METRICS_MASK` reports them.
+ */
+uint32_t app_alarm_metrics(void);
+
+/**
+ * Update the alarm levels of a unit from a new measurement.
+ *
+ * @return true if any level differs from the one last acknowledged by the cloud
+ *         and is not being sent
+ */
+bool app_alarm_evaluate(struct app_alarm_state *state, uint8_t unit_id,
+			const struct qm30vt2_measurement *meas);
+
+/* Level changes of one unit taken with app_alarm_take() */
+struct app_alarm_events {
+	uint8_t unit_id;
+	uint8_t count;
+	struct {
+		uint8_t rule;
+		uint8_t level;
+		/* Level last acknowledged by the cloud */
+		uint8_t prev;
+	} event[APP_ALARM_RULE_COUNT];
+};
+
+/**
+ * Take every level that is neither reported nor being sent and mark it as
+ * being sent, with the unit locked.
+ *
+ * @return number of events taken
+ */
+size_t app_alarm_take(struct app_alarm_state *state, uint8_t unit_id,
+		      struct app_alarm_events *events);
+
+/**
+ * Send taken events to the `alarm` stream path, without holding the unit lock.
+ * A level counts as reported once Golioth acknowledges its event, which is
+ * looked up by unit ID with app_bus_unit_lock(); an event that fails is sent
+ * again after the next evaluation.
+ *
+ * @return number of events sent or a negative error code
+ */
+int app_alarm_report(struct golioth_client *client, const struct app_alarm_events *events,
+		     const struct qm30vt2_measurement *meas);
+
+#endif /* __APP_ALARM_H__ */
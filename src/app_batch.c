@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_batch, LOG_LEVEL_DBG);
+
+#include <zephyr/kernel.h>
+
+#include "app_batch.h"
+#include "app_log.h"
+#include "app_settings.h"
+
+static struct app_batch_sample samples[CONFIG_APP_BATCH_CAPACITY];
+
+/* Index of the oldest sample and number of samples in the buffer */
+static size_t head;
+static size_t count;
+
+/* Sequence number of the sample at head */
+static uint32_t head_seq;
+
+static uint32_t overwritten;
+
+void app_batch_push(const struct qm30vt2_measurement *meas, uint8_t unit_id, uint32_t metrics,
+		    int64_t uptime_ms)
+{
+	struct app_batch_sample *sample;
+
+	if (count == ARRAY_SIZE(samples)) {
+		/* Buffer full, discard the oldest sample */
+		head = (head + 1) % ARRAY_SIZE(samples);
+		head_seq++;
+		count--;
+		overwritten++;
+		APP_LOG_WRN_RL("Sample buffer full, %u samples overwritten", overwritten);
+	}
+
+	sample = &samples[(head + count) % ARRAY_SIZE(samples)];
+	sample->uptime_ms = uptime_ms;
+	sample->unit_id = unit_id;
+	sample->metrics = metrics;
+	sample->meas = *meas;
+	count++;
+}
+
+size_t app_batch_count(void)
+{
+	return count;
+}
+
+const struct app_batch_sample *app_batch_get(size_t idx)
+{
+	if (idx >= count) {
+		return NULL;
+	}
+
+	return &samples[(head + idx) % ARRAY_SIZE(samples)];
+}
+
+uint32_t app_batch_seq(void)
+{
+	return head_seq;
+}
+
+void app_batch_drop_until(uint32_t seq)
+{
+	int32_t drop_count = (int32_t)(seq - head_seq);
+
+	/* Already overwritten */
+	if (drop_count <= 0) {
+		return;
+	}
+
+	drop_count = MIN(drop_count, count);
+
+	head = (head + drop_count) % ARRAY_SIZE(samples);
+	head_seq += drop_count;
+	count -= drop_count;
+}
+
+bool app_batch_flush_due(void)
+{
+	if (count == 0) {
+		return false;
+	}
+
+	if (count >= get_batch_flush_count()) {
+		return true;
+	}
+
+	return (k_uptime_get() - samples[head].uptime_ms) >=
+	       (int64_t)get_batch_max_age_s() * MSEC_PER_SEC;
+}
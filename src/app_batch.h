@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_BATCH_H__
+#define __APP_BATCH_H__
+
+/** Fixed-capacity RAM ring buffer of timestamped QM30VT2 measurements.
+ *
+ * Measurements are pushed after every poll and uploaded in batches so several
+ * samples share a single LightDB Stream request. A batch is due when the
+ * `BATCH_FLUSH_COUNT` setting is reached or the oldest sample is older than
+ * `BATCH_MAX_AGE_S`. When the buffer is full the oldest sample is overwritten.
+ *
+ * Samples are numbered in push order, so an upload can release the samples it
+ * sent with app_batch_drop_until() even if older ones were overwritten since.
+ *
+ * The buffer is owned by the main loop and is not thread safe.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "qm30vt2.h"
+
+struct app_batch_sample {
+	/* k_uptime_get() when the sample was taken */
+	int64_t uptime_ms;
+	/* Modbus unit the sample was read from */
+	uint8_t unit_id;
+	/* Bitmask of the metrics to upload */
+	uint32_t metrics;
+	struct qm30vt2_measurement meas;
+};
+
+/** Add a sample read at uptime_ms, see app_acq_meas. */
+void app_batch_push(const struct qm30vt2_measurement *meas, uint8_t unit_id, uint32_t metrics,
+		    int64_t uptime_ms);
+size_t app_batch_count(void);
+const struct app_batch_sample *app_batch_get(size_t idx);
+/** Sequence number of the oldest sample, the one app_batch_get(0) returns. */
+uint32_t app_batch_seq(void);
+/** Drop the samples numbered before seq that are still buffered. */
+void app_batch_drop_until(uint32_t seq);
+bool app_batch_flush_due(void);
+
+#endif /* __APP_BATCH_H__ */
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_bench, LOG_LEVEL_DBG);
+
+#include <zephyr/kernel.h>
+
+#include "app_acq.h"
+#include "app_bench.h"
+#include "app_bus.h"
+#ifdef CONFIG_APP_REGMAP
+#include "app_regmap.h"
+#endif
+#include "app_sensors.h"
+#include "app_settings.h"
+#include "qm30vt2.h"
+#include "qm30vt2_sim.h"
+
+/* Timeouts and CRC errors injected in the faulty bus stage */
+#define BENCH_FAULT_PCT 5
+
+/* Implemented in app_bench_host.c, which is built into the native simulator runner */
+uint64_t app_bench_host_cpu_ns(void);
+
+struct bench_stage {
+	const char *name;
+	uint32_t runs;
+	uint32_t errors;
+	uint64_t cpu_ns;
+	/* Simulated time, which only advances while waiting on the bus */
+	uint64_t bus_us;
+	/* Output size of the last run */
+	int bytes;
+};
+
+/* Returns a negative error or the output size of one run */
+typedef int (*bench_fn)(void *arg);
+
+/* Common METRICS_MASK values, compared on the read, decode and encode stages */
+struct bench_mask {
+	const char *name;
+	uint32_t metrics;
+};
+
+static const struct bench_mask bench_masks[] = {
+	{"all", QM30VT2_METRICS_ALL},
+	/* Without temperature in °F and velocities in in/sec */
+	{"metric units",
+	 QM30VT2_METRICS_ALL &
+		 ~(BIT(QM30VT2_METRIC_TEMP_F) | BIT(QM30VT2_METRIC_X_VEL_PEAK_IN) |
+		   BIT(QM30VT2_METRIC_X_VEL_RMS_IN) | BIT(QM30VT2_METRIC_Z_VEL_PEAK_IN) |
+		   BIT(QM30VT2_METRIC_Z_VEL_RMS_IN))},
+	/* What ISO 10816 zones and a temperature trend need */
+	{"rms velocity, temp",
+	 BIT(QM30VT2_METRIC_TEMP_C) | BIT(QM30VT2_METRIC_X_VEL_RMS_MM) |
+		 BIT(QM30VT2_METRIC_Z_VEL_RMS_MM)},
+};
+
+static uint16_t holding_reg[QM30VT2_ALIAS_SIZE];
+static struct qm30vt2_measurement meas;
+static uint8_t payload_buf[CONFIG_APP_SENSORS_PAYLOAD_BUF_SIZE];
+
+static void bench_stage_run(struct bench_stage *stage, bench_fn fn, void *arg)
+{
+	int64_t start_ticks = k_uptime_ticks();
+	uint64_t start_ns = app_bench_host_cpu_ns();
+
+	for (uint32_t i = 0; i < CONFIG_APP_BENCHMARK_RUNS; i++) {
+		int ret = fn(arg);
+
+		if (ret < 0) {
+			stage->errors++;
+		} else {
+			stage->bytes = ret;
+		}
+	}
+
+	stage->runs = CONFIG_APP_BENCHMARK_RUNS;
+	stage->cpu_ns = app_bench_host_cpu_ns() - start_ns;
+	stage->bus_us = k_ticks_to_us_floor64(k_uptime_ticks() - start_ticks);
+}
+
+static void bench_stage_print(const struct bench_stage *stage)
+{
+	/* Hundredths of a run per second of bus time */
+	uint64_t rate = stage->bus_us ? (uint64_t)stage->runs * USEC_PER_SEC * 100 / stage->bus_us
+				      : 0;
+
+	printk("%-20s %6u %6u %10llu %10llu %6llu.%02llu %6d\n", stage->name, stage->runs,
+	       stage->errors, (unsigned long long)(stage->cpu_ns / stage->runs),
+	       (unsigned long long)(stage->bus_us / stage->runs),
+	       (unsigned long long)(rate / 100), (unsigned long long)(rate % 100), stage->bytes);
+}
+
+/* Stage functions take the metric mask as argument, all metrics if NULL */
+static uint32_t bench_metrics(const void *arg)
+{
+	return arg ? ((const struct bench_mask *)arg)->metrics : QM30VT2_METRICS_ALL;
+}
+
+static int bench_read(void *arg)
+{
+	uint16_t first;
+	uint16_t count = qm30vt2_reg_span(bench_metrics(arg), &first);
+	int err = app_acq_read(APP_BUS_UNIT_ID_MIN, QM30VT2_ALIAS_BASE_ADDR + first,
+			       &holding_reg[first], count, K_FOREVER);
+
+	/* Modbus exceptions are positive */
+	return err ? -EIO : count * sizeof(uint16_t);
+}
+
+static int bench_decode(void *arg)
+{
+	return qm30vt2_decode(holding_reg, &meas, bench_metrics(arg));
+}
+
+static int bench_encode(void *arg)
+{
+	return app_sensors_encode(&meas, bench_metrics(arg), get_batch_flush_count(),
+				  payload_buf, sizeof(payload_buf));
+}
+
+/* Stages repeated for each of bench_masks */
+static const bench_fn mask_stage_fns[] = {bench_read, bench_decode, bench_encode};
+static const char *const mask_stage_names[] = {"read", "decode", "encode batch"};
+
+#ifdef CONFIG_APP_REGMAP
+#define BENCH_REGMAP_FIELD(member, NAME, idx, dec, sgn, ...)                                       \
+	{                                                                                          \
+		.name = #member,                                                                   \
+		.addr = QM30VT2_ALIAS_BASE_ADDR + (idx),                                           \
+		.type = (sgn) ? APP_REGMAP_S16 : APP_REGMAP_U16,                                   \
+		.decimals = (dec),                                                                 \
+	},
+
+/* The alias block as a generic register map, to compare with qm30vt2_decode() */
+static const struct app_regmap_field bench_regmap[] = {QM30VT2_METRICS(BENCH_REGMAP_FIELD)};
+
+BUILD_ASSERT(ARRAY_SIZE(bench_regmap) <= CONFIG_APP_REGMAP_MAX_FIELDS);
+
+static struct app_regmap_sample regmap_sample;
+
+static int bench_regmap_decode(void *arg)
+{
+	/* The map is read in one transaction, which lays out registers like holding_reg */
+	return app_regmap_decode(holding_reg, &regmap_sample);
+}
+#endif /* CONFIG_APP_REGMAP */
+
+static int bench_read_and_stream(void *arg)
+{
+	app_acq_poll_all();
+	app_sensors_read_and_stream();
+
+	return 0;
+}
+
+int app_bench_run(void)
+{
+	struct bench_stage stages[] = {
+		{.name = "modbus read"},
+		{.name = "decode"},
+		{.name = "encode batch"},
+		{.name = "read and stream"},
+		{.name = "modbus read, faults"},
+	};
+	struct bench_stage mask_stages[ARRAY_SIZE(bench_masks)][ARRAY_SIZE(mask_stage_fns)];
+	struct bench_stage regmap_stage = {.name = "regmap decode"};
+	struct qm30vt2_sim_config sim_cfg;
+	struct qm30vt2_sim_stats sim_stats;
+	int ret = 0;
+
+	printk("Benchmark: %u runs per stage, batches of %d records encoded as %s\n",
+	       CONFIG_APP_BENCHMARK_RUNS, get_batch_flush_count(),
+	       IS_ENABLED(CONFIG_APP_SENSORS_STREAM_FORMAT_CBOR) ? "CBOR" : "JSON");
+
+	bench_stage_run(&stages[0], bench_read, NULL);
+	bench_stage_run(&stages[1], bench_decode, NULL);
+	bench_stage_run(&stages[2], bench_encode, NULL);
+
+	IF_ENABLED(CONFIG_APP_REGMAP, (
+		if (app_regmap_set("qm30vt2", bench_regmap, ARRAY_SIZE(bench_regmap)) == 0) {
+			bench_stage_run(&regmap_stage, bench_regmap_decode, NULL);
+		} else {
+			regmap_stage.errors++;
+		}
+	));
+
+	/* Only this stage polls, so the read stages see every injected fault */
+	app_acq_polling_set(true);
+	bench_stage_run(&stages[3], bench_read_and_stream, NULL);
+	app_acq_polling_set(false);
+
+	qm30vt2_sim_config_get(&sim_cfg);
+	qm30vt2_sim_stats_reset();
+
+	qm30vt2_sim_configure(&(struct qm30vt2_sim_config){
+		.latency_ms = sim_cfg.latency_ms,
+		.timeout_pct = BENCH_FAULT_PCT,
+		.crc_error_pct = BENCH_FAULT_PCT,
+		.noise_pct = sim_cfg.noise_pct,
+	});
+	bench_stage_run(&stages[4], bench_read, NULL);
+	qm30vt2_sim_stats_get(&sim_stats);
+	qm30vt2_sim_configure(&sim_cfg);
+
+	for (size_t i = 0; i < ARRAY_SIZE(bench_masks); i++) {
+		for (size_t j = 0; j < ARRAY_SIZE(mask_stage_fns); j++) {
+			mask_stages[i][j] = (struct bench_stage){.name = bench_masks[i].name};
+			bench_stage_run(&mask_stages[i][j], mask_stage_fns[j],
+					(void *)&bench_masks[i]);
+		}
+	}
+
+	printk("%-20s %6s %6s %10s %10s %9s %6s\n", "stage", "runs", "errors", "cpu_ns/run",
+	       "bus_us/run", "runs/s", "bytes");
+	for (size_t i = 0; i < ARRAY_SIZE(stages); i++) {
+		bench_stage_print(&stages[i]);
+	}
+	if (regmap_stage.runs) {
+		bench_stage_print(&regmap_stage);
+	}
+
+	printk("Injected %u timeouts and %u CRC errors in %u requests\n", sim_stats.timeouts,
+	       sim_stats.crc_errors, sim_stats.requests);
+
+	/* Bytes are the registers read, and the payload of a batch */
+	for (size_t j = 0; j < ARRAY_SIZE(mask_stage_fns); j++) {
+		printk("\n%-20s %6s %6s %10s %10s %9s %6s\n", mask_stage_names[j], "runs",
+		       "errors", "cpu_ns/run", "bus_us/run", "runs/s", "bytes");
+		for (size_t i = 0; i < ARRAY_SIZE(bench_masks); i++) {
+			bench_stage_print(&mask_stages[i][j]);
+		}
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(stages) - 1; i++) {
+		if (stages[i].errors) {
+			LOG_ERR("Stage \"%s\" failed %u times", stages[i].name, stages[i].errors);
+			ret = -EIO;
+		}
+	}
+
+	if (regmap_stage.errors) {
+		LOG_ERR("Stage \"%s\" failed %u times", regmap_stage.name, regmap_stage.errors);
+		ret = -EIO;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(bench_masks); i++) {
+		if (mask_stages[i][0].errors) {
+			LOG_ERR("Reading \"%s\" failed %u times", bench_masks[i].name,
+				mask_stages[i][0].errors);
+			ret = -EIO;
+		}
+	}
+
+	/* Every injected fault must be seen by the client, and nothing else */
+	if (stages[4].errors != sim_stats.timeouts + sim_stats.crc_errors) {
+		LOG_ERR("Client saw %u errors for %u injected faults", stages[4].errors,
+			sim_stats.timeouts + sim_stats.crc_errors);
+		ret = -EIO;
+	}
+
+	return ret;
+}
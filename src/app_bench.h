@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_BENCH_H__
+#define __APP_BENCH_H__
+
+/** Acquisition benchmark for the native_sim build.
+ *
+ * Polls the simulated QM30VT2 (see qm30vt2_sim.h) through the real Modbus
+ * client and measures, for each stage of the acquisition path:
+ *
+ * - the host CPU time per run, so regressions in qm30vt2.c and app_sensors.c
+ *   show up on a plain Linux box;
+ * - the simulated bus time per run, from which polls per second follow.
+ *
+ * Stages are an on-demand Modbus read through the acquisition thread (see
+ * app_acq.h), register decoding, encoding a batch of records as a stream
+ * payload, and a full round of a poll by the acquisition thread processed by
+ * app_sensors_read_and_stream() (alarms, report-by-exception and batching,
+ * without uploading). The read is repeated with timeouts and CRC errors
+ * injected. Results are printed as a table.
+ */
+
+/** Run the benchmark, returns 0 if every stage completed without errors. */
+int app_bench_run(void);
+
+#endif /* __APP_BENCH_H__ */
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_boot, LOG_LEVEL_DBG);
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+#include "app_boot.h"
+
+/* Longest trace line, with every phase at the largest uptime */
+#define BOOT_TRACE_MAX_LEN (APP_BOOT_PHASE_COUNT * sizeof(", display_ready 4294967295 ms"))
+
+static const char *const phase_names[] = {
+	[APP_BOOT_MAIN] = "main",
+	[APP_BOOT_ACQ_READY] = "acq_ready",
+	[APP_BOOT_FIRST_SAMPLE] = "first_sample",
+	[APP_BOOT_DISPLAY_READY] = "display_ready",
+	[APP_BOOT_NET_READY] = "net_ready",
+	[APP_BOOT_FIRST_CONNECT] = "first_connect",
+	[APP_BOOT_FIRST_UPLOAD] = "first_upload",
+};
+BUILD_ASSERT(ARRAY_SIZE(phase_names) == APP_BOOT_PHASE_COUNT);
+
+/* Uptime in milliseconds of each phase, 0 until it is reached */
+static atomic_t phase_ms[APP_BOOT_PHASE_COUNT];
+
+static K_THREAD_STACK_DEFINE(boot_wq_stack, CONFIG_APP_BOOT_WQ_STACK_SIZE);
+static struct k_work_q boot_wq;
+
+void app_boot_init(void)
+{
+	const struct k_work_queue_config cfg = {
+		.name = "boot_wq",
+	};
+
+	k_work_queue_start(&boot_wq, boot_wq_stack, K_THREAD_STACK_SIZEOF(boot_wq_stack),
+			   CONFIG_APP_BOOT_WQ_PRIORITY, &cfg);
+}
+
+int app_boot_submit(struct k_work *work)
+{
+	return k_work_submit_to_queue(&boot_wq, work);
+}
+
+void app_boot_mark(enum app_boot_phase phase)
+{
+	/* Phases reached in the first millisecond count as 1 ms, 0 means not reached */
+	uint32_t now = MAX(k_uptime_get_32(), 1);
+
+	if (atomic_cas(&phase_ms[phase], 0, now)) {
+		LOG_INF("Boot phase %s reached at %u ms", phase_names[phase], now);
+	}
+}
+
+uint32_t app_boot_phase_ms(enum app_boot_phase phase)
+{
+	return atomic_get(&phase_ms[phase]);
+}
+
+void app_boot_log(void)
+{
+	char sbuf[BOOT_TRACE_MAX_LEN];
+	size_t pos = 0;
+
+	sbuf[0] = '\0';
+
+	for (size_t i = 0; i < APP_BOOT_PHASE_COUNT; i++) {
+		uint32_t ms = atomic_get(&phase_ms[i]);
+
+		if (ms) {
+			pos += snprintk(&sbuf[pos], sizeof(sbuf) - pos, "%s%s %u ms",
+					pos ? ", " : "", phase_names[i], ms);
+		}
+	}
+
+	LOG_INF("Boot trace: %s", sbuf);
+}
+
+int app_boot_to_json(char *buf, size_t len)
+{
+	size_t pos = 0;
+	int ret;
+
+	ret = snprintk(buf, len, "{");
+	for (size_t i = 0; (i < APP_BOOT_PHASE_COUNT) && (ret >= 0) && (pos + ret < len); i++) {
+		pos += ret;
+		ret = snprintk(&buf[pos], len - pos, "%s\"%s_ms\":%u", i ? "," : "",
+			       phase_names[i], (uint32_t)atomic_get(&phase_ms[i]));
+	}
+	if ((ret >= 0) && (pos + ret < len)) {
+		pos += ret;
+		ret = snprintk(&buf[pos], len - pos, "}");
+	}
+
+	if ((ret < 0) || (pos + ret >= len)) {
+		return -ENOMEM;
+	}
+
+	return pos + ret;
+}
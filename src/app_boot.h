@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_BOOT_H__
+#define __APP_BOOT_H__
+
+/** Boot work queue and boot-phase trace.
+ *
+ * Slow boot steps that the acquisition path does not depend on, such as
+ * resetting the Ostentus display or reading the modem firmware version, run as
+ * work items on a dedicated boot work queue while main() starts polling. The
+ * network is brought up beside both, by the LTE link controller on nRF91 or a
+ * connect thread in main.c otherwise, since joining a network blocks for much
+ * longer than any of these steps.
+ *
+ * Each phase of the boot is marked with the uptime at which it was first
+ * reached. Phases are logged as they are reached, and the whole trace is logged
+ * and written to the `startup` LightDB State path once the first sensor upload
+ * has been accepted (see app_state_report_startup()).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+enum app_boot_phase {
+	/* main() entered */
+	APP_BOOT_MAIN,
+	/* Cached settings applied and periodic polls enabled */
+	APP_BOOT_ACQ_READY,
+	/* First successful poll */
+	APP_BOOT_FIRST_SAMPLE,
+	/* Ostentus answered after its reset and shows the slideshow */
+	APP_BOOT_DISPLAY_READY,
+	/* Network up: LTE registered, or Wi-Fi/DHCP done */
+	APP_BOOT_NET_READY,
+	/* Golioth client connected */
+	APP_BOOT_FIRST_CONNECT,
+	/* First sensor upload accepted by Golioth */
+	APP_BOOT_FIRST_UPLOAD,
+	APP_BOOT_PHASE_COUNT,
+};
+
+/** Start the boot work queue. */
+void app_boot_init(void);
+
+/** Run a boot step on the boot work queue. */
+int app_boot_submit(struct k_work *work);
+
+/** Record the current uptime for a phase, unless it was already reached. */
+void app_boot_mark(enum app_boot_phase phase);
+
+/** Uptime in milliseconds at which a phase was reached, 0 if not yet. */
+uint32_t app_boot_phase_ms(enum app_boot_phase phase);
+
+/** Log every phase with the uptime it was reached at, in one line. */
+void app_boot_log(void);
+
+/** Phases as a JSON object of `<phase>_ms` members, 0 for phases not reached. */
+int app_boot_to_json(char *buf, size_t len);
+
+#endif /* __APP_BOOT_H__ */
@@ -0,0 +1,911 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_bus, LOG_LEVEL_DBG);
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/atomic.h>
+
+#include "app_acq.h"
+#include "app_adaptive.h"
+#include "app_bus.h"
+#include "app_settings.h"
+#include "app_time.h"
+
+/* The last unit list received is kept in flash, the desired state is reset once applied */
+#define BUS_SETTINGS_ROOT  "app/bus"
+#define BUS_SETTINGS_UNITS "units"
+
+static struct app_bus_unit units[CONFIG_APP_BUS_MAX_UNITS] = {
+	{
+		.cfg = {
+			.id = CONFIG_APP_BUS_DEFAULT_UNIT_ID,
+			.period_s = 0,
+		},
+		.poll_now = true,
+	},
+};
+static size_t unit_count = 1;
+
+/* New configuration received from the cloud, applied by the polling thread */
+static struct app_bus_unit_cfg pending_cfg[CONFIG_APP_BUS_MAX_UNITS];
+static size_t pending_count;
+static bool pending;
+
+/* Unit list in flash */
+static struct app_bus_unit_cfg saved_cfg[CONFIG_APP_BUS_MAX_UNITS];
+static size_t saved_count;
+
+static K_MUTEX_DEFINE(bus_lock);
+
+/* Set when a unit enters or leaves quarantine, see app_bus_health_changed() */
+static atomic_t health_changed;
+
+/* Set when a new unit list is applied, see app_bus_units_changed() */
+static atomic_t units_changed;
+
+/* Throughput window */
+static int64_t window_start_ms;
+static uint32_t window_polls;
+static uint64_t window_busy_us;
+
+/* Results of the last completed window */
+static uint32_t polls_per_s_milli;
+static uint32_t avg_poll_us;
+
+/* Duration of app_sensors_read_and_stream() rounds since boot */
+static uint32_t loop_count;
+static uint32_t loop_last_us;
+static uint32_t loop_max_us;
+static uint64_t loop_sum_us;
+
+/* Lateness of scheduled polls against their deadline since boot */
+static uint32_t jitter_count;
+static uint32_t missed_count;
+static uint32_t jitter_last_us;
+static uint32_t jitter_max_us;
+static uint64_t jitter_sum_us;
+
+/* Upper bounds of the latency histogram buckets, the last bucket is open */
+static const uint32_t latency_bucket_ms[] = {10, 20, 50, 100, 200, 500, 1000};
+BUILD_ASSERT(ARRAY_SIZE(latency_bucket_ms) == APP_BUS_LATENCY_BUCKETS - 1);
+
+static const char *const error_names[] = {
+	[APP_BUS_ERR_TIMEOUT] = "timeout",
+	[APP_BUS_ERR_CRC] = "crc",
+	[APP_BUS_ERR_EXCEPTION] = "exception",
+	[APP_BUS_ERR_OTHER] = "other",
+};
+BUILD_ASSERT(ARRAY_SIZE(error_names) == APP_BUS_ERR_COUNT);
+
+static const char *const health_names[] = {
+	[APP_BUS_HEALTH_HEALTHY] = "healthy",
+	[APP_BUS_HEALTH_DEGRADED] = "degraded",
+	[APP_BUS_HEALTH_QUARANTINED] = "quarantined",
+};
+BUILD_ASSERT(ARRAY_SIZE(health_names) == APP_BUS_HEALTH_COUNT);
+
+uint32_t app_bus_unit_period_s(const struct app_bus_unit *unit)
+{
+	if (unit->cfg.period_s) {
+		return unit->cfg.period_s;
+	}
+
+	if (app_adaptive_enabled() && unit->adaptive.period_s) {
+		return unit->adaptive.period_s;
+	}
+
+	return get_loop_delay_s();
+}
+
+/* First deadline after now_ms on the grid of a period, aligned to Unix time if the
+ * wall clock is known
+ */
+static int64_t grid_next_ms(int64_t now_ms, uint32_t period_s)
+{
+	int64_t period_ms = (int64_t)period_s * MSEC_PER_SEC;
+	int64_t offset_ms = 0;
+
+	if (app_time_unix_offset_ms(&offset_ms)) {
+		offset_ms = 0;
+	}
+
+	return ((now_ms + offset_ms) / period_ms + 1) * period_ms - offset_ms;
+}
+
+/* Next deadline of a unit, moved to the grid of its current period if that changed.
+ * A quarantined unit is not scheduled before its next probe.
+ */
+static int64_t unit_deadline_ms(struct app_bus_unit *unit, int64_t now_ms)
+{
+	uint32_t period_s = app_bus_unit_period_s(unit);
+
+	if ((unit->deadline_ms == 0) || (unit->sched_period_s != period_s)) {
+		unit->deadline_ms = grid_next_ms(MAX(now_ms, unit->probe_ms), period_s);
+		unit->sched_period_s = period_s;
+	}
+
+	return unit->deadline_ms;
+}
+
+static int units_validate(const struct app_bus_unit_cfg *cfg, size_t count)
+{
+	if (count == 0 || count > ARRAY_SIZE(pending_cfg)) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (cfg[i].id < APP_BUS_UNIT_ID_MIN || cfg[i].id > APP_BUS_UNIT_ID_MAX) {
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static void units_set_pending(const struct app_bus_unit_cfg *cfg, size_t count)
+{
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	memcpy(pending_cfg, cfg, count * sizeof(*cfg));
+	pending_count = count;
+	pending = true;
+
+	k_mutex_unlock(&bus_lock);
+}
+
+static int bus_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+	struct app_bus_unit_cfg cfg[CONFIG_APP_BUS_MAX_UNITS];
+	const char *next;
+	ssize_t rc;
+
+	if (settings_name_steq(name, BUS_SETTINGS_UNITS, &next) && !next) {
+		if ((len % sizeof(cfg[0])) || (len > sizeof(cfg))) {
+			return -EINVAL;
+		}
+
+		rc = read_cb(cb_arg, cfg, len);
+		if (rc < 0) {
+			return rc;
+		}
+
+		if (units_validate(cfg, len / sizeof(cfg[0]))) {
+			return -EINVAL;
+		}
+
+		memcpy(saved_cfg, cfg, len);
+		saved_count = len / sizeof(cfg[0]);
+		units_set_pending(saved_cfg, saved_count);
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_bus, BUS_SETTINGS_ROOT, NULL, bus_settings_set, NULL, NULL);
+
+static bool units_saved(const struct app_bus_unit_cfg *cfg, size_t count)
+{
+	if (count != saved_count) {
+		return false;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if ((cfg[i].id != saved_cfg[i].id) || (cfg[i].period_s != saved_cfg[i].period_s) ||
+		    (cfg[i].regmap != saved_cfg[i].regmap)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int app_bus_set_units(const struct app_bus_unit_cfg *cfg, size_t count)
+{
+	int err;
+
+	err = units_validate(cfg, count);
+	if (err) {
+		return err;
+	}
+
+	units_set_pending(cfg, count);
+
+	if (!units_saved(cfg, count)) {
+		/* Copied member by member so padding is stored as zeros */
+		memset(saved_cfg, 0, sizeof(saved_cfg));
+		for (size_t i = 0; i < count; i++) {
+			saved_cfg[i].id = cfg[i].id;
+			saved_cfg[i].period_s = cfg[i].period_s;
+			saved_cfg[i].regmap = cfg[i].regmap;
+		}
+		saved_count = count;
+
+		err = settings_save_one(BUS_SETTINGS_ROOT "/" BUS_SETTINGS_UNITS, saved_cfg,
+					count * sizeof(saved_cfg[0]));
+		if (err) {
+			LOG_WRN("Failed to save units: %d", err);
+		}
+	}
+
+	/* New units are due immediately */
+	app_acq_poll_all();
+
+	return 0;
+}
+
+int app_bus_load_units(void)
+{
+	int err = settings_load_subtree(BUS_SETTINGS_ROOT);
+
+	if (err) {
+		LOG_WRN("Failed to load units: %d", err);
+		return err;
+	}
+
+	if (saved_count) {
+		LOG_INF("Applied %zu saved units", saved_count);
+	}
+
+	return 0;
+}
+
+/* Called with bus_lock held */
+static void apply_pending_cfg(void)
+{
+	if (pending) {
+		memset(units, 0, sizeof(units));
+
+		for (size_t i = 0; i < pending_count; i++) {
+			units[i].cfg = pending_cfg[i];
+			units[i].poll_now = true;
+		}
+
+		unit_count = pending_count;
+		pending = false;
+		atomic_set(&units_changed, 1);
+
+		LOG_INF("Polling %zu units", unit_count);
+	}
+}
+
+size_t app_bus_unit_count(void)
+{
+	return unit_count;
+}
+
+struct app_bus_unit *app_bus_next_due(int64_t now_ms)
+{
+	struct app_bus_unit *due = NULL;
+
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	apply_pending_cfg();
+
+	if (window_start_ms == 0) {
+		window_start_ms = now_ms;
+	}
+
+	for (size_t i = 0; i < unit_count; i++) {
+		struct app_bus_unit *unit = &units[i];
+		int64_t deadline_ms;
+		uint32_t missed;
+
+		if (unit->poll_now) {
+			unit->poll_now = false;
+			unit->due_ms = 0;
+			unit->retry_ms = 0;
+			unit->attempt = 0;
+			due = unit;
+			break;
+		}
+
+		/* A failed poll is retried before the unit goes back to its grid */
+		if (unit->retry_ms) {
+			if (unit->retry_ms > now_ms) {
+				continue;
+			}
+
+			unit->due_ms = 0;
+			unit->retry_ms = 0;
+			due = unit;
+			break;
+		}
+
+		deadline_ms = unit_deadline_ms(unit, now_ms);
+		if (deadline_ms > now_ms) {
+			continue;
+		}
+
+		/* Deadlines that passed since this one are skipped, the grid stays put */
+		missed = (now_ms - deadline_ms) / ((int64_t)unit->sched_period_s * MSEC_PER_SEC);
+		if (missed) {
+			unit->diag.missed += missed;
+			missed_count += missed;
+
+			LOG_DBG("Unit %u: %u deadlines missed", unit->cfg.id, missed);
+		}
+
+		unit->due_ms = deadline_ms;
+		unit->deadline_ms = grid_next_ms(now_ms, unit->sched_period_s);
+		unit->attempt = 0;
+		due = unit;
+		break;
+	}
+
+	k_mutex_unlock(&bus_lock);
+
+	return due;
+}
+
+void app_bus_poll_start(struct app_bus_unit *unit)
+{
+	int64_t late_us;
+
+	/* Requested polls have no deadline to miss */
+	if (unit->due_ms == 0) {
+		return;
+	}
+
+	late_us = k_ticks_to_us_floor64(k_uptime_ticks()) - unit->due_ms * USEC_PER_MSEC;
+
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	jitter_count++;
+	jitter_last_us = CLAMP(late_us, 0, UINT32_MAX);
+	jitter_max_us = MAX(jitter_max_us, jitter_last_us);
+	jitter_sum_us += jitter_last_us;
+
+	k_mutex_unlock(&bus_lock);
+}
+
+struct app_bus_unit *app_bus_unit_lock(uint8_t unit_id)
+{
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	for (size_t i = 0; i < unit_count; i++) {
+		if (units[i].cfg.id == unit_id) {
+			return &units[i];
+		}
+	}
+
+	k_mutex_unlock(&bus_lock);
+
+	return NULL;
+}
+
+void app_bus_unit_unlock(void)
+{
+	k_mutex_unlock(&bus_lock);
+}
+
+uint32_t app_bus_latency_bucket_ms(size_t bucket)
+{
+	return (bucket < ARRAY_SIZE(latency_bucket_ms)) ? latency_bucket_ms[bucket] : UINT32_MAX;
+}
+
+/* Errors as returned by the Zephyr Modbus client */
+static enum app_bus_error classify_error(int err)
+{
+	if (err == -ETIMEDOUT) {
+		return APP_BUS_ERR_TIMEOUT;
+	}
+	if (err == -EIO) {
+		return APP_BUS_ERR_CRC;
+	}
+	if (err > 0) {
+		return APP_BUS_ERR_EXCEPTION;
+	}
+
+	return APP_BUS_ERR_OTHER;
+}
+
+static void diag_add_latency(struct app_bus_diag *diag, uint32_t count, uint32_t duration_us)
+{
+	size_t bucket = 0;
+
+	while ((bucket < ARRAY_SIZE(latency_bucket_ms)) &&
+	       (duration_us > latency_bucket_ms[bucket] * USEC_PER_MSEC)) {
+		bucket++;
+	}
+	diag->latency_hist[bucket]++;
+
+	diag->latency_min_us = (count == 1) ? duration_us : MIN(diag->latency_min_us, duration_us);
+	diag->latency_max_us = MAX(diag->latency_max_us, duration_us);
+	diag->latency_sum_us += duration_us;
+}
+
+/* Timeouts and CRC errors may be transient, and are what an unresponsive unit costs the bus */
+static bool is_bus_error(int err)
+{
+	enum app_bus_error type = classify_error(err);
+
+	return (type == APP_BUS_ERR_TIMEOUT) || (type == APP_BUS_ERR_CRC);
+}
+
+/* Update the health of a unit with the final result of a poll, called with bus_lock held */
+static void unit_health_update(struct app_bus_unit *unit, int err, int64_t now_ms)
+{
+	enum app_bus_health prev = unit->health;
+
+	if (err == 0) {
+		unit->fail_streak = 0;
+		unit->probe_ms = 0;
+		unit->health = unit->attempt ? APP_BUS_HEALTH_DEGRADED : APP_BUS_HEALTH_HEALTHY;
+	} else if (classify_error(err) == APP_BUS_ERR_EXCEPTION) {
+		/* The unit answered, so it is alive */
+		unit->fail_streak = 0;
+		unit->probe_ms = 0;
+		unit->health = APP_BUS_HEALTH_DEGRADED;
+	} else if (is_bus_error(err)) {
+		unit->fail_streak++;
+
+		if (unit->fail_streak >= CONFIG_APP_BUS_QUARANTINE_AFTER) {
+			unit->health = APP_BUS_HEALTH_QUARANTINED;
+			unit->probe_ms = now_ms + CONFIG_APP_BUS_PROBE_INTERVAL_S * MSEC_PER_SEC;
+			/* Rescheduled after the probe interval */
+			unit->deadline_ms = 0;
+		} else {
+			unit->health = APP_BUS_HEALTH_DEGRADED;
+		}
+	}
+
+	if ((prev != APP_BUS_HEALTH_QUARANTINED) &&
+	    (unit->health == APP_BUS_HEALTH_QUARANTINED)) {
+		LOG_WRN("Unit %u quarantined after %u failed polls, probing every %d s",
+			unit->cfg.id, unit->fail_streak, CONFIG_APP_BUS_PROBE_INTERVAL_S);
+		atomic_set(&health_changed, 1);
+	} else if ((prev == APP_BUS_HEALTH_QUARANTINED) &&
+		   (unit->health != APP_BUS_HEALTH_QUARANTINED)) {
+		LOG_INF("Unit %u answered, quarantine lifted", unit->cfg.id);
+		atomic_set(&health_changed, 1);
+	} else if (prev != unit->health) {
+		LOG_DBG("Unit %u: %s", unit->cfg.id, health_names[unit->health]);
+	}
+}
+
+void app_bus_poll_done(struct app_bus_unit *unit, int err, uint32_t duration_us)
+{
+	int64_t now = k_uptime_get();
+
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	unit->polls++;
+	if (err) {
+		enum app_bus_error type = classify_error(err);
+
+		unit->failures++;
+		unit->diag.errors[type]++;
+
+		LOG_DBG("Unit %u: %s after %u us", unit->cfg.id, error_names[type], duration_us);
+	} else {
+		unit->last_ok_ms = now;
+		unit->cal_polls++;
+		unit->cal_max_us = MAX(unit->cal_max_us, duration_us);
+	}
+
+	diag_add_latency(&unit->diag, unit->polls, duration_us);
+
+	window_polls++;
+	window_busy_us += duration_us;
+
+	/* Quarantined units are only probed, a failed probe is not retried */
+	if (err && is_bus_error(err) && (unit->health != APP_BUS_HEALTH_QUARANTINED) &&
+	    (unit->attempt < CONFIG_APP_BUS_RETRIES)) {
+		unit->retry_ms = now + ((int64_t)CONFIG_APP_BUS_RETRY_BACKOFF_MS << unit->attempt);
+		unit->attempt++;
+		unit->retries++;
+
+		LOG_DBG("Unit %u: retry %u in %lld ms", unit->cfg.id, unit->attempt,
+			(long long)(unit->retry_ms - now));
+	} else {
+		unit_health_update(unit, err, now);
+	}
+
+	k_mutex_unlock(&bus_lock);
+}
+
+bool app_bus_health_changed(void)
+{
+	return atomic_set(&health_changed, 0) != 0;
+}
+
+bool app_bus_units_changed(void)
+{
+	return atomic_set(&units_changed, 0) != 0;
+}
+
+void app_bus_cal_reset(void)
+{
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	for (size_t i = 0; i < unit_count; i++) {
+		units[i].cal_polls = 0;
+		units[i].cal_max_us = 0;
+	}
+
+	k_mutex_unlock(&bus_lock);
+}
+
+int app_bus_cal_timeout_ms(uint32_t *timeout_ms)
+{
+	uint32_t max_us = 0;
+	size_t measured = 0;
+	uint32_t ms;
+
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	for (size_t i = 0; i < unit_count; i++) {
+		const struct app_bus_unit *unit = &units[i];
+
+		/* Quarantined units are probed with whatever timeout the others allow */
+		if (unit->health == APP_BUS_HEALTH_QUARANTINED) {
+			continue;
+		}
+
+		if (unit->cal_polls < CONFIG_APP_MODBUS_CAL_POLLS) {
+			k_mutex_unlock(&bus_lock);
+			return -EAGAIN;
+		}
+
+		max_us = MAX(max_us, unit->cal_max_us);
+		measured++;
+	}
+
+	k_mutex_unlock(&bus_lock);
+
+	if (measured == 0) {
+		return -EAGAIN;
+	}
+
+	ms = DIV_ROUND_UP((uint64_t)max_us * CONFIG_APP_MODBUS_CAL_MARGIN_PCT / 100,
+			  USEC_PER_MSEC);
+	*timeout_ms = CLAMP(ROUND_UP(ms, 10), CONFIG_APP_MODBUS_TIMEOUT_MIN_MS,
+			    CONFIG_APP_MODBUS_TIMEOUT_MS);
+
+	return 0;
+}
+
+void app_bus_loop_done(uint32_t duration_us)
+{
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	loop_count++;
+	loop_last_us = duration_us;
+	loop_max_us = MAX(loop_max_us, duration_us);
+	loop_sum_us += duration_us;
+
+	k_mutex_unlock(&bus_lock);
+}
+
+int64_t app_bus_next_poll_ms(void)
+{
+	int64_t now = k_uptime_get();
+	int64_t next = INT64_MAX;
+
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	for (size_t i = 0; i < unit_count; i++) {
+		struct app_bus_unit *unit = &units[i];
+
+		if (unit->poll_now) {
+			next = MIN(next, now);
+		} else if (unit->retry_ms) {
+			next = MIN(next, unit->retry_ms);
+		} else {
+			next = MIN(next, unit_deadline_ms(unit, now));
+		}
+	}
+
+	k_mutex_unlock(&bus_lock);
+
+	/* Pick up a new configuration within one LOOP_DELAY_S */
+	return MIN(next, now + (int64_t)get_loop_delay_s() * MSEC_PER_SEC);
+}
+
+void app_bus_poll_all(void)
+{
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	for (size_t i = 0; i < unit_count; i++) {
+		/* Quarantined units are only probed on their own schedule */
+		if (units[i].health != APP_BUS_HEALTH_QUARANTINED) {
+			units[i].poll_now = true;
+		}
+	}
+
+	k_mutex_unlock(&bus_lock);
+}
+
+int app_bus_units_to_json(char *buf, size_t len)
+{
+	size_t pos = 0;
+	size_t count;
+	int ret;
+
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	/* Report a configuration that has not been applied yet as the current one */
+	count = pending ? pending_count : unit_count;
+
+	ret = snprintk(buf, len, "[");
+	for (size_t i = 0; (i < count) && (ret >= 0) && (pos + ret < len); i++) {
+		const struct app_bus_unit_cfg *cfg = pending ? &pending_cfg[i] : &units[i].cfg;
+
+		uint32_t effective_s = pending ? (cfg->period_s ? cfg->period_s : get_loop_delay_s())
+					       : app_bus_unit_period_s(&units[i]);
+
+		pos += ret;
+		ret = snprintk(&buf[pos], len - pos,
+			       "%s{\"id\":%u,\"period_s\":%u,\"effective_period_s\":%u%s}",
+			       i ? "," : "", cfg->id, cfg->period_s, effective_s,
+			       cfg->regmap ? ",\"regmap\":true" : "");
+	}
+	if ((ret >= 0) && (pos + ret < len)) {
+		pos += ret;
+		ret = snprintk(&buf[pos], len - pos, "]");
+	}
+
+	k_mutex_unlock(&bus_lock);
+
+	if ((ret < 0) || (pos + ret >= len)) {
+		return -ENOMEM;
+	}
+
+	return pos + ret;
+}
+
+int app_bus_stats_to_json(char *buf, size_t len)
+{
+	int64_t now = k_uptime_get();
+	uint32_t proposed_ms = 0;
+	size_t pos = 0;
+	int ret;
+
+	/* 0 until every unit has been measured */
+	(void)app_bus_cal_timeout_ms(&proposed_ms);
+
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	ret = snprintk(buf, len,
+		       "{\"polls_per_s\":%u.%03u,\"avg_poll_us\":%u,\"baud\":%u,\"timeout_ms\":%u,"
+		       "\"proposed_timeout_ms\":%u,\"units\":[",
+		       polls_per_s_milli / 1000, polls_per_s_milli % 1000, avg_poll_us,
+		       get_modbus_baud(), app_acq_timeout_ms(), proposed_ms);
+
+	for (size_t i = 0; (i < unit_count) && (ret >= 0) && (pos + ret < len); i++) {
+		const struct app_bus_unit *unit = &units[i];
+		/* -1 if the unit has never been read successfully */
+		int32_t stale_s = unit->last_ok_ms ? (now - unit->last_ok_ms) / MSEC_PER_SEC : -1;
+
+		pos += ret;
+		ret = snprintk(&buf[pos], len - pos,
+			       "%s{\"id\":%u,\"health\":\"%s\",\"stale_s\":%d,\"polls\":%u,"
+			       "\"failures\":%u,\"retries\":%u}",
+			       i ? "," : "", unit->cfg.id, health_names[unit->health], stale_s,
+			       unit->polls, unit->failures, unit->retries);
+	}
+	if ((ret >= 0) && (pos + ret < len)) {
+		pos += ret;
+		ret = snprintk(&buf[pos], len - pos, "]}");
+	}
+
+	k_mutex_unlock(&bus_lock);
+
+	if ((ret < 0) || (pos + ret >= len)) {
+		return -ENOMEM;
+	}
+
+	return pos + ret;
+}
+
+int app_bus_health_to_json(char *buf, size_t len)
+{
+	size_t pos = 0;
+	int ret;
+
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	ret = snprintk(buf, len,
+		       "{\"loop_count\":%u,\"loop_last_us\":%u,\"loop_avg_us\":%u,"
+		       "\"loop_max_us\":%u,\"jitter_last_us\":%u,\"jitter_avg_us\":%u,"
+		       "\"jitter_max_us\":%u,\"missed_deadlines\":%u,\"units\":[",
+		       loop_count, loop_last_us, loop_count ? (uint32_t)(loop_sum_us / loop_count) : 0,
+		       loop_max_us, jitter_last_us,
+		       jitter_count ? (uint32_t)(jitter_sum_us / jitter_count) : 0, jitter_max_us,
+		       missed_count);
+
+	for (size_t i = 0; (i < unit_count) && (ret >= 0) && (pos + ret < len); i++) {
+		const struct app_bus_unit *unit = &units[i];
+		const struct app_bus_diag *diag = &unit->diag;
+		const uint32_t *hist = diag->latency_hist;
+
+		BUILD_ASSERT(APP_BUS_LATENCY_BUCKETS == 8);
+
+		pos += ret;
+		ret = snprintk(&buf[pos], len - pos,
+			       "%s{\"id\":%u,\"polls\":%u,\"missed\":%u,\"timeout\":%u,\"crc\":%u,"
+			       "\"exception\":%u,\"other\":%u,\"latency_min_us\":%u,"
+			       "\"latency_avg_us\":%u,\"latency_max_us\":%u,"
+			       "\"latency_hist\":[%u,%u,%u,%u,%u,%u,%u,%u]}",
+			       i ? "," : "", unit->cfg.id, unit->polls, diag->missed,
+			       diag->errors[APP_BUS_ERR_TIMEOUT], diag->errors[APP_BUS_ERR_CRC],
+			       diag->errors[APP_BUS_ERR_EXCEPTION], diag->errors[APP_BUS_ERR_OTHER],
+			       diag->latency_min_us,
+			       unit->polls ? (uint32_t)(diag->latency_sum_us / unit->polls) : 0,
+			       diag->latency_max_us, hist[0], hist[1], hist[2], hist[3], hist[4],
+			       hist[5], hist[6], hist[7]);
+	}
+	if ((ret >= 0) && (pos + ret < len)) {
+		pos += ret;
+		ret = snprintk(&buf[pos], len - pos, "]}");
+	}
+
+	k_mutex_unlock(&bus_lock);
+
+	if ((ret < 0) || (pos + ret >= len)) {
+		return -ENOMEM;
+	}
+
+	return pos + ret;
+}
+
+static bool encode_uint(zcbor_state_t *map, const char *key, uint32_t value)
+{
+	return zcbor_tstr_encode_ptr(map, key, strlen(key)) && zcbor_uint32_put(map, value);
+}
+
+int app_bus_diag_encode(zcbor_state_t *map, uint8_t unit_id)
+{
+	struct app_bus_diag total = {0};
+	uint32_t proposed_ms = 0;
+	uint32_t polls = 0;
+	size_t matched = 0;
+	char key[sizeof("latency_gt_4294967295ms")];
+	bool ok;
+
+	(void)app_bus_cal_timeout_ms(&proposed_ms);
+
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	for (size_t i = 0; i < unit_count; i++) {
+		const struct app_bus_unit *unit = &units[i];
+
+		if (unit_id && (unit->cfg.id != unit_id)) {
+			continue;
+		}
+
+		for (size_t e = 0; e < APP_BUS_ERR_COUNT; e++) {
+			total.errors[e] += unit->diag.errors[e];
+		}
+		total.missed += unit->diag.missed;
+		for (size_t b = 0; b < APP_BUS_LATENCY_BUCKETS; b++) {
+			total.latency_hist[b] += unit->diag.latency_hist[b];
+		}
+		if (unit->polls) {
+			total.latency_min_us = polls ? MIN(total.latency_min_us,
+							   unit->diag.latency_min_us)
+						     : unit->diag.latency_min_us;
+		}
+		total.latency_max_us = MAX(total.latency_max_us, unit->diag.latency_max_us);
+		total.latency_sum_us += unit->diag.latency_sum_us;
+		polls += unit->polls;
+		matched++;
+	}
+
+	if (matched == 0) {
+		k_mutex_unlock(&bus_lock);
+		return -ENOENT;
+	}
+
+	ok = encode_uint(map, "units", matched) && encode_uint(map, "polls", polls);
+
+	for (size_t e = 0; ok && (e < APP_BUS_ERR_COUNT); e++) {
+		ok = encode_uint(map, error_names[e], total.errors[e]);
+	}
+
+	ok = ok && encode_uint(map, "latency_min_us", total.latency_min_us) &&
+	     encode_uint(map, "latency_avg_us",
+			 polls ? (uint32_t)(total.latency_sum_us / polls) : 0) &&
+	     encode_uint(map, "latency_max_us", total.latency_max_us);
+
+	for (size_t b = 0; ok && (b < APP_BUS_LATENCY_BUCKETS); b++) {
+		if (b < ARRAY_SIZE(latency_bucket_ms)) {
+			snprintk(key, sizeof(key), "latency_le_%ums", latency_bucket_ms[b]);
+		} else {
+			snprintk(key, sizeof(key), "latency_gt_%ums", latency_bucket_ms[b - 1]);
+		}
+		ok = encode_uint(map, key, total.latency_hist[b]);
+	}
+
+	ok = ok && encode_uint(map, "loop_count", loop_count) &&
+	     encode_uint(map, "loop_last_us", loop_last_us) &&
+	     encode_uint(map, "loop_avg_us",
+			 loop_count ? (uint32_t)(loop_sum_us / loop_count) : 0) &&
+	     encode_uint(map, "loop_max_us", loop_max_us) &&
+	     encode_uint(map, "jitter_last_us", jitter_last_us) &&
+	     encode_uint(map, "jitter_avg_us",
+			 jitter_count ? (uint32_t)(jitter_sum_us / jitter_count) : 0) &&
+	     encode_uint(map, "jitter_max_us", jitter_max_us) &&
+	     encode_uint(map, "missed_deadlines", total.missed) &&
+	     encode_uint(map, "timeout_ms", app_acq_timeout_ms()) &&
+	     encode_uint(map, "proposed_timeout_ms", proposed_ms);
+
+	k_mutex_unlock(&bus_lock);
+
+	return ok ? 0 : -ENOMEM;
+}
+
+void app_bus_report(void)
+{
+	int64_t now = k_uptime_get();
+	uint32_t proposed_ms = 0;
+	bool proposed;
+	int64_t elapsed_ms;
+
+	proposed = (app_bus_cal_timeout_ms(&proposed_ms) == 0);
+
+	/* The window counters are updated by the acquisition thread */
+	k_mutex_lock(&bus_lock, K_FOREVER);
+
+	elapsed_ms = now - window_start_ms;
+	if (elapsed_ms > 0) {
+		polls_per_s_milli = (uint64_t)window_polls * MSEC_PER_SEC * 1000 / elapsed_ms;
+	}
+	avg_poll_us = window_polls ? window_busy_us / window_polls : 0;
+
+	/* A poll every avg_poll_us is the most one bus can sustain */
+	LOG_INF("Bus: %u.%03u polls/s, avg poll %u us (capacity ~%u polls/s)",
+		polls_per_s_milli / 1000, polls_per_s_milli % 1000, avg_poll_us,
+		avg_poll_us ? USEC_PER_SEC / avg_poll_us : 0);
+
+	if (jitter_count) {
+		LOG_INF("Poll jitter: last %u us, avg %u us, max %u us over %u polls, %u deadlines "
+			"missed",
+			jitter_last_us, (uint32_t)(jitter_sum_us / jitter_count), jitter_max_us,
+			jitter_count, missed_count);
+	}
+	if (proposed) {
+		LOG_INF("Modbus timeout %u ms, calibration proposes %u ms", app_acq_timeout_ms(),
+			proposed_ms);
+	}
+	if (app_acq_meas_dropped()) {
+		LOG_WRN("%u samples not delivered to every sink", app_acq_meas_dropped());
+	}
+
+	for (size_t i = 0; i < unit_count; i++) {
+		const struct app_bus_unit *unit = &units[i];
+
+		const uint32_t *errors = unit->diag.errors;
+
+		if (unit->last_ok_ms) {
+			LOG_INF("Unit %u (%s): last read %lld s ago, %u/%u polls failed, "
+				"%u retries",
+				unit->cfg.id, health_names[unit->health],
+				(long long)((now - unit->last_ok_ms) / MSEC_PER_SEC), unit->failures,
+				unit->polls, unit->retries);
+		} else {
+			LOG_WRN("Unit %u (%s): never read, %u/%u polls failed, %u retries",
+				unit->cfg.id, health_names[unit->health], unit->failures,
+				unit->polls, unit->retries);
+		}
+
+		if (unit->failures) {
+			LOG_INF("Unit %u: %u timeout, %u CRC, %u exception, %u other errors",
+				unit->cfg.id, errors[APP_BUS_ERR_TIMEOUT], errors[APP_BUS_ERR_CRC],
+				errors[APP_BUS_ERR_EXCEPTION], errors[APP_BUS_ERR_OTHER]);
+		}
+	}
+
+	window_start_ms = now;
+	window_polls = 0;
+	window_busy_us = 0;
+
+	k_mutex_unlock(&bus_lock);
+}
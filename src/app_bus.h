@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_BUS_H__
+#define __APP_BUS_H__
+
+/** Poll scheduler for several QM30VT2 sensors sharing one RS-485 bus.
+ *
+ * Each configured unit has its own poll period (0 follows the adaptive period,
+ * see app_adaptive.h, or the `LOOP_DELAY_S` setting) and keeps its latest
+ * measurement. Units that are due are polled back to back by the acquisition
+ * thread (see app_acq.h), which sleeps until the absolute deadline returned by
+ * app_bus_next_poll_ms(), and their results are processed by
+ * app_sensors_read_and_stream() in the main loop.
+ *
+ * Deadlines lie on a fixed grid of multiples of the period, in Unix time once
+ * the wall clock is known (see app_time.h) and in uptime until then, so units
+ * with the same period are sampled at the same instants on every device. The
+ * grid does not drift with the time polls take, and a late poll does not shift
+ * it: deadlines that passed while a poll was pending are skipped and counted as
+ * missed. Polls requested with app_bus_poll_all() (button, settings changes) and
+ * the first poll of a new unit happen right away, in addition to the grid.
+ * When the period of a unit changes it moves to the grid of the new period.
+ *
+ * A poll that fails with a timeout or a CRC error is retried up to
+ * `CONFIG_APP_BUS_RETRIES` times, after a backoff that doubles with each retry.
+ * Other units are polled during the backoff, so retries only cost the bus the
+ * retried transactions. Each unit has a health state: healthy while polls
+ * succeed at the first attempt, degraded after a poll that needed a retry or
+ * failed, and quarantined after `CONFIG_APP_BUS_QUARANTINE_AFTER` consecutive
+ * polls failed on the bus. A quarantined unit is not retried, skips
+ * app_bus_poll_all() and is only probed every `CONFIG_APP_BUS_PROBE_INTERVAL_S`,
+ * on its grid, so an unplugged sensor does not spend the bus time of the
+ * healthy ones waiting for timeouts. The first successful probe restores it.
+ *
+ * The scheduler also tracks achieved polls per second, the average time a
+ * poll occupies the bus and how long ago each unit was last read successfully
+ * (staleness). These are logged and written to the `bus` LightDB State path so
+ * the number of sensors one bus can serve can be sized from real data.
+ *
+ * For tuning bus timing, each unit also counts transaction errors by cause and
+ * keeps a histogram of transaction latency, and the duration of each round of
+ * app_sensors_read_and_stream() is tracked, as is how late each scheduled poll
+ * starts against its deadline (poll jitter). These diagnostics are returned by
+ * the `get_modbus_stats` RPC and optionally streamed to the `health` path.
+ *
+ * To tune the Modbus response timeout, the longest successful poll of each unit
+ * is measured since the last calibration reset. app_bus_cal_timeout_ms()
+ * proposes the tightest timeout that would have let every one of them through,
+ * with a margin; it is reported with the bus statistics and applied by the
+ * acquisition thread when the `MODBUS_TIMEOUT_MS` setting is 0.
+ *
+ * Units are polled by the acquisition thread and processed by the main loop.
+ * The unit list, the schedule and the counters are guarded by one mutex, which
+ * the functions here take themselves. The main loop holds app_bus_unit_lock()
+ * while it reads or updates a unit. The acquisition thread reads the
+ * configuration of the unit returned by app_bus_next_due() without it, as a new
+ * unit list is only applied by that thread, in app_bus_next_due().
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_adaptive.h"
+#include "app_alarm.h"
+#include "app_summary.h"
+#include "qm30vt2.h"
+
+#include <zcbor_encode.h>
+
+#define APP_BUS_UNIT_ID_MIN 1
+#define APP_BUS_UNIT_ID_MAX 247
+
+#define APP_BUS_LATENCY_BUCKETS 8
+
+enum app_bus_error {
+	/* No response within the Modbus rx_timeout */
+	APP_BUS_ERR_TIMEOUT,
+	/* Response with a bad CRC */
+	APP_BUS_ERR_CRC,
+	/* Modbus exception response */
+	APP_BUS_ERR_EXCEPTION,
+	APP_BUS_ERR_OTHER,
+	APP_BUS_ERR_COUNT,
+};
+
+enum app_bus_health {
+	APP_BUS_HEALTH_HEALTHY,
+	/* Last poll needed a retry or failed */
+	APP_BUS_HEALTH_DEGRADED,
+	/* Unresponsive, only probed every CONFIG_APP_BUS_PROBE_INTERVAL_S */
+	APP_BUS_HEALTH_QUARANTINED,
+	APP_BUS_HEALTH_COUNT,
+};
+
+struct app_bus_diag {
+	uint32_t errors[APP_BUS_ERR_COUNT];
+	/* Grid deadlines skipped because the unit was still waiting for an earlier one */
+	uint32_t missed;
+	uint32_t latency_min_us;
+	uint32_t latency_max_us;
+	uint64_t latency_sum_us;
+	/* Transactions per latency bucket, see app_bus_latency_bucket_ms() */
+	uint32_t latency_hist[APP_BUS_LATENCY_BUCKETS];
+};
+
+struct app_bus_unit_cfg {
+	uint8_t id;
+	/* Poll period in seconds, 0 to follow LOOP_DELAY_S */
+	uint32_t period_s;
+	/* Polled with the generic register map instead of as a QM30VT2, see app_regmap.h */
+	bool regmap;
+};
+
+struct app_bus_unit {
+	struct app_bus_unit_cfg cfg;
+	/* Next grid deadline, 0 until scheduled */
+	int64_t deadline_ms;
+	/* Period the deadline was scheduled with */
+	uint32_t sched_period_s;
+	/* Poll right away, outside the grid */
+	bool poll_now;
+	/* Deadline the current poll was scheduled for, 0 if it was requested or a retry */
+	int64_t due_ms;
+	/* Uptime at which a failed poll is retried, 0 if none is pending */
+	int64_t retry_ms;
+	/* Retries made for the current poll */
+	uint8_t attempt;
+	enum app_bus_health health;
+	/* Consecutive polls that still failed on the bus after their retries */
+	uint32_t fail_streak;
+	/* Earliest uptime of the next probe while quarantined, 0 otherwise */
+	int64_t probe_ms;
+	/* Uptime of the last successful poll, 0 if never */
+	int64_t last_ok_ms;
+	/* Transactions, retries included */
+	uint32_t polls;
+	uint32_t failures;
+	uint32_t retries;
+	/* Successful polls and the longest of them since the last calibration reset */
+	uint32_t cal_polls;
+	uint32_t cal_max_us;
+	struct app_bus_diag diag;
+	struct qm30vt2_measurement meas;
+	/* Values last reported for each metric, for report-by-exception */
+	struct qm30vt2_measurement reported;
+	/* Uptime of the last record with every metric, 0 if never */
+	int64_t reported_full_ms;
+	struct app_alarm_state alarm;
+	struct app_adaptive_state adaptive;
+	/* Statistics of each metric over the current summary window */
+	struct app_summary_stats summary[QM30VT2_ALIAS_SIZE];
+	/* Uptime at which the summary window started, 0 if not started */
+	int64_t summary_start_ms;
+	/* Metrics whose window statistics were already sent, when an upload stopped midway */
+	uint32_t summary_sent;
+};
+
+/** Poll a new list of units, which is saved in flash if it changed. */
+int app_bus_set_units(const struct app_bus_unit_cfg *cfg, size_t count);
+
+/** Poll the unit list saved in flash, if any, until a new one is received. */
+int app_bus_load_units(void);
+
+size_t app_bus_unit_count(void);
+
+/**
+ * Get the next unit that is due for a poll at uptime now_ms, or NULL if none.
+ * Units are returned once per deadline; call app_bus_poll_done() after polling.
+ */
+struct app_bus_unit *app_bus_next_due(int64_t now_ms);
+
+/** Record how late a poll returned by app_bus_next_due() starts on the bus. */
+void app_bus_poll_start(struct app_bus_unit *unit);
+
+/** Record the result of a poll, scheduling a retry or updating the unit health. */
+void app_bus_poll_done(struct app_bus_unit *unit, int err, uint32_t duration_us);
+
+/** Returns true once after a unit entered or left quarantine. */
+bool app_bus_health_changed(void);
+
+/**
+ * Returns true once after a new unit list was applied, which restarts the
+ * measurement of poll durations for timeout calibration.
+ */
+bool app_bus_units_changed(void);
+
+/** Restart the measurement of poll durations for timeout calibration. */
+void app_bus_cal_reset(void);
+
+/**
+ * Propose a Modbus response timeout: the longest successful poll of any unit
+ * times CONFIG_APP_MODBUS_CAL_MARGIN_PCT, rounded up to 10 ms and bounded by
+ * CONFIG_APP_MODBUS_TIMEOUT_MIN_MS and CONFIG_APP_MODBUS_TIMEOUT_MS.
+ *
+ * @return 0 on success, -EAGAIN until every unit that is not quarantined has
+ * CONFIG_APP_MODBUS_CAL_POLLS successful polls.
+ */
+int app_bus_cal_timeout_ms(uint32_t *timeout_ms);
+
+/**
+ * Find a unit by ID and lock it against reconfiguration, returns NULL if the
+ * unit is no longer polled. Release it with app_bus_unit_unlock().
+ */
+struct app_bus_unit *app_bus_unit_lock(uint8_t unit_id);
+void app_bus_unit_unlock(void);
+
+/** Record the duration of one round of polling and uploading. */
+void app_bus_loop_done(uint32_t duration_us);
+
+/**
+ * Upper bound in milliseconds of a latency histogram bucket. The last bucket
+ * has no upper bound and returns UINT32_MAX.
+ */
+uint32_t app_bus_latency_bucket_ms(size_t bucket);
+
+/** Current poll period of a unit in seconds. */
+uint32_t app_bus_unit_period_s(const struct app_bus_unit *unit);
+
+/** Uptime in milliseconds at which the next unit is due. */
+int64_t app_bus_next_poll_ms(void);
+
+/**
+ * Poll every unit that is not quarantined right away, keeping their grids, called
+ * by the acquisition thread.
+ */
+void app_bus_poll_all(void);
+
+int app_bus_units_to_json(char *buf, size_t len);
+int app_bus_stats_to_json(char *buf, size_t len);
+int app_bus_health_to_json(char *buf, size_t len);
+
+/**
+ * Add the transaction diagnostics of one unit to an open map, or the totals of
+ * all units if unit_id is 0.
+ *
+ * @return 0 on success, -ENOENT if the unit is not polled, -ENOMEM if the map
+ * is full.
+ */
+int app_bus_diag_encode(zcbor_state_t *map, uint8_t unit_id);
+
+/** Log bus statistics and reset the throughput window. */
+void app_bus_report(void);
+
+#endif /* __APP_BUS_H__ */
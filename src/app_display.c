@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_display, LOG_LEVEL_DBG);
+
+#include <libostentus.h>
+#include <libostentus_regmap.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "app_acq.h"
+#include "app_boot.h"
+#include "app_display.h"
+#include "app_sensors.h"
+#include "qm30vt2.h"
+
+#ifdef CONFIG_ALUDEL_BATTERY_MONITOR
+#include <battery_monitor.h>
+#endif
+
+/* Bounds the wait for the acquisition thread publishing a new sample */
+#define DISPLAY_READ_TIMEOUT K_MSEC(100)
+
+/* Longest formatted slide value, including the terminator */
+#define DISPLAY_VALUE_LEN 32
+
+/* I2C bytes of a slide update besides its value: register address and slide key */
+#define DISPLAY_SLIDE_OVERHEAD 2
+
+/* Ostentus stops answering while it restarts after a reset, then answers once it is
+ * ready. It is polled from the first delay on until the timeout.
+ */
+#define DISPLAY_RESET_MIN_MS	 50
+#define DISPLAY_RESET_POLL_MS	 25
+#define DISPLAY_RESET_TIMEOUT_MS 2000
+
+/* Adds the slide of one QM30VT2_METRICS entry */
+#define DISPLAY_SLIDE_ADD(name, NAME, idx, div, sgn, qty, label, ...)                              \
+	ostentus_slide_add(o_dev, NAME, label, strlen(label));
+
+static const struct device *o_dev = DEVICE_DT_GET_ANY(golioth_ostentus);
+
+/* Value last sent for each slide, the firmware slide is only set once at init */
+static char slide_cache[FIRMWARE][DISPLAY_VALUE_LEN];
+
+/* Since boot, to estimate the I2C time of the updates that were skipped */
+static uint64_t total_bytes_sent;
+static uint64_t total_busy_us;
+
+struct display_cycle {
+	uint32_t slides_sent;
+	uint32_t bytes_sent;
+	uint32_t busy_us;
+	uint32_t slides_skipped;
+	uint32_t bytes_skipped;
+};
+
+/* Uptime of the last refresh */
+static int64_t last_refresh_ms;
+/* A sample was published since the last refresh */
+static atomic_t meas_pending;
+/* Set once the slideshow is set up, refreshes before that are deferred */
+static atomic_t display_ready;
+
+static const char *display_fw_version;
+
+/* Send a slide value over I2C only if it differs from what the display shows */
+static void display_slide_set(struct display_cycle *cycle, slide_key key, char *value)
+{
+	size_t len = strnlen(value, DISPLAY_VALUE_LEN - 1);
+	uint32_t start;
+	uint32_t busy_us;
+
+	if (strncmp(slide_cache[key], value, DISPLAY_VALUE_LEN) == 0) {
+		cycle->slides_skipped++;
+		cycle->bytes_skipped += DISPLAY_SLIDE_OVERHEAD + len;
+		return;
+	}
+
+	start = k_cycle_get_32();
+	if (ostentus_slide_set(o_dev, key, value, len) == 0) {
+		/* A failed update is retried at the next refresh */
+		memcpy(slide_cache[key], value, len);
+		slide_cache[key][len] = '\0';
+	}
+	busy_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+	cycle->slides_sent++;
+	cycle->bytes_sent += DISPLAY_SLIDE_OVERHEAD + len;
+	cycle->busy_us += busy_us;
+}
+
+static void display_cycle_report(const struct display_cycle *cycle)
+{
+	uint32_t saved_us = 0;
+
+	total_bytes_sent += cycle->bytes_sent;
+	total_busy_us += cycle->busy_us;
+
+	/* Skipped updates would have cost the average I2C time per byte */
+	if (total_bytes_sent) {
+		saved_us = total_busy_us * cycle->bytes_skipped / total_bytes_sent;
+	}
+
+	LOG_INF("Display: %u slides sent (%u bytes, %u us), %u unchanged (%u bytes, ~%u us "
+		"saved)",
+		cycle->slides_sent, cycle->bytes_sent, cycle->busy_us, cycle->slides_skipped,
+		cycle->bytes_skipped, saved_us);
+}
+
+static void display_work_handler(struct k_work *work)
+{
+	static struct app_acq_meas msg;
+	struct display_cycle cycle = {0};
+	char sbuf[DISPLAY_VALUE_LEN];
+
+	/* The sample stays pending, init refreshes the display once it is ready */
+	if (!atomic_get(&display_ready)) {
+		return;
+	}
+
+	last_refresh_ms = k_uptime_get();
+
+	/* Golioth custom hardware for demos */
+	IF_ENABLED(CONFIG_ALUDEL_BATTERY_MONITOR, (
+		display_slide_set(&cycle, BATTERY_V, get_batt_v_str());
+		display_slide_set(&cycle, BATTERY_LVL, get_batt_lvl_str());
+	));
+
+	if (atomic_clear(&meas_pending) &&
+	    (zbus_chan_read(&app_acq_meas_chan, &msg, DISPLAY_READ_TIMEOUT) == 0)) {
+		/* Update slide values on Ostentus
+		 *  -values should be sent as strings
+		 *  -use the enum from app_sensors.h for slide key values
+		 *  -the most recently read unit is shown
+		 */
+		LOG_DBG("Showing unit %u", msg.unit_id);
+
+		/* Metric slide keys follow QM30VT2_METRICS, metrics that are not polled show "-" */
+		for (size_t i = 0; i < QM30VT2_METRIC_COUNT; i++) {
+			if (msg.metrics & BIT(i)) {
+				qm30vt2_metric_format(sbuf, sizeof(sbuf), &msg.meas, i);
+			} else {
+				strcpy(sbuf, "-");
+			}
+			display_slide_set(&cycle, i, sbuf);
+		}
+	}
+
+	display_cycle_report(&cycle);
+}
+
+static K_WORK_DELAYABLE_DEFINE(display_work, display_work_handler);
+
+void app_display_refresh(void)
+{
+	/* A refresh that is already scheduled is left alone, which rate-limits bursts */
+	k_work_schedule(&display_work,
+			K_TIMEOUT_ABS_MS(last_refresh_ms +
+					 CONFIG_APP_DISPLAY_INTERVAL_S * MSEC_PER_SEC));
+}
+
+/* Wait until Ostentus answers after a reset, instead of a fixed delay */
+static int display_wait_ready(char *version, size_t len)
+{
+	int64_t deadline = k_uptime_get() + DISPLAY_RESET_TIMEOUT_MS;
+	int err;
+
+	k_msleep(DISPLAY_RESET_MIN_MS);
+
+	while (true) {
+		err = ostentus_version_get(o_dev, version, len);
+		if (!err || (k_uptime_get() >= deadline)) {
+			return err;
+		}
+		k_msleep(DISPLAY_RESET_POLL_MS);
+	}
+}
+
+static void display_init_work_handler(struct k_work *work)
+{
+	char version[32] = {0};
+	uint32_t start = k_uptime_get_32();
+	int err;
+
+	ostentus_reset(o_dev);
+
+	err = display_wait_ready(version, sizeof(version));
+	if (err) {
+		LOG_ERR("Ostentus not responding after reset: %d", err);
+		return;
+	}
+
+	LOG_INF("Ostentus reports firmware version: %s, ready after %u ms", version,
+		k_uptime_get_32() - start);
+
+	/* Update Ostentus LEDS using bitmask (Power On and Battery) */
+	ostentus_led_bitmask(o_dev, LED_POW | LED_BAT);
+
+	/* Show Golioth Logo on Ostentus ePaper screen */
+	ostentus_show_splash(o_dev);
+
+	/* Set up a slideshow on Ostentus
+	 *  - add up to 256 slides
+	 *  - use the enum in app_sensors.h to add new keys
+	 *  - values are updated using these keys
+	 */
+	QM30VT2_METRICS(DISPLAY_SLIDE_ADD)
+	IF_ENABLED(CONFIG_ALUDEL_BATTERY_MONITOR, (
+		ostentus_slide_add(o_dev, BATTERY_V, LABEL_BATTERY, strlen(LABEL_BATTERY));
+		ostentus_slide_add(o_dev, BATTERY_LVL, LABEL_BATTERY, strlen(LABEL_BATTERY));
+	));
+	ostentus_slide_add(o_dev, FIRMWARE, LABEL_FIRMWARE, strlen(LABEL_FIRMWARE));
+
+	/* Set the title of the Ostentus summary slide (optional) */
+	ostentus_summary_title(o_dev, SUMMARY_TITLE, strlen(SUMMARY_TITLE));
+
+	/* Update the Firmware slide with the firmware version */
+	ostentus_slide_set(o_dev, FIRMWARE, (char *)display_fw_version,
+			   strlen(display_fw_version));
+
+	/* Start Ostentus slideshow with 30 second delay between slides */
+	ostentus_slideshow(o_dev, 30000);
+
+	atomic_set(&display_ready, 1);
+	app_boot_mark(APP_BOOT_DISPLAY_READY);
+
+	/* Show the samples taken meanwhile */
+	app_display_refresh();
+}
+
+static K_WORK_DEFINE(display_init_work, display_init_work_handler);
+
+void app_display_init(const char *fw_version)
+{
+	display_fw_version = fw_version;
+	app_boot_submit(&display_init_work);
+}
+
+static void display_meas_cb(const struct zbus_channel *chan)
+{
+	atomic_set(&meas_pending, 1);
+	app_display_refresh();
+}
+
+ZBUS_LISTENER_DEFINE(display_lis, display_meas_cb);
+ZBUS_CHAN_ADD_OBS(app_acq_meas_chan, display_lis, 3);
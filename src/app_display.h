@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_DISPLAY_H__
+#define __APP_DISPLAY_H__
+
+/** Ostentus display sink.
+ *
+ * Shows the latest sample published on app_acq_meas_chan (see app_acq.h) on
+ * the metric slides, along with the battery slides. A listener on the channel
+ * schedules a refresh on the system work queue at most every
+ * `CONFIG_APP_DISPLAY_INTERVAL_S` seconds. The refresh reads the latest message,
+ * so samples published in between are skipped and I2C traffic to the display
+ * does not follow the poll rate.
+ *
+ * The last value sent to each slide is cached, and only slides whose formatted
+ * value changed are sent. Each refresh logs the I2C bytes and time spent on
+ * the slides that were sent, and the bytes and estimated time saved on those
+ * that were unchanged.
+ */
+
+/**
+ * Reset Ostentus and set up the slideshow on the boot work queue (see
+ * app_boot.h). Refreshes wait until Ostentus answers after the reset.
+ */
+void app_display_init(const char *fw_version);
+
+/** Schedule a refresh, e.g. after new battery readings. */
+void app_display_refresh(void);
+
+#endif /* __APP_DISPLAY_H__ */
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include "app_fixed.h"
+
+static const uint32_t pow10[APP_FIXED_MAX_DECIMALS + 1] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+uint32_t app_fixed_pow10(uint8_t decimals)
+{
+	return pow10[MIN(decimals, APP_FIXED_MAX_DECIMALS)];
+}
+
+int app_fixed_format(char *buf, size_t len, int32_t val, uint8_t decimals)
+{
+	/* Negate as unsigned so INT32_MIN does not overflow */
+	uint32_t mag = (val < 0) ? -(uint32_t)val : (uint32_t)val;
+	uint32_t div;
+
+	if (decimals == 0) {
+		return snprintk(buf, len, "%d", val);
+	}
+
+	decimals = MIN(decimals, APP_FIXED_MAX_DECIMALS);
+	div = pow10[decimals];
+
+	return snprintk(buf, len, "%s%u.%0*u", (val < 0) ? "-" : "", mag / div, decimals,
+			mag % div);
+}
+
+int32_t app_fixed_from_float(float x, uint8_t decimals)
+{
+	float scaled = x * app_fixed_pow10(decimals);
+
+	if (scaled >= (float)INT32_MAX) {
+		return INT32_MAX;
+	}
+	if (scaled <= (float)INT32_MIN) {
+		return INT32_MIN;
+	}
+
+	return (int32_t)(scaled + ((scaled < 0) ? -0.5f : 0.5f));
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_FIXED_H__
+#define __APP_FIXED_H__
+
+/** Decimal fixed-point values.
+ *
+ * A value is an integer count of 10^-decimals, e.g. 512 with 4 decimals is
+ * 0.0512. QM30VT2 registers already hold their values this way, so keeping
+ * them as fixed-point lets logs, slides and stream payloads be written with
+ * integer arithmetic only, without floating point printf support.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define APP_FIXED_MAX_DECIMALS 9
+
+/* Longest formatted value, "-2147483648" with a decimal point */
+#define APP_FIXED_STR_LEN sizeof("-2.147483648")
+
+/** 10^decimals, for decimals up to APP_FIXED_MAX_DECIMALS */
+uint32_t app_fixed_pow10(uint8_t decimals);
+
+/**
+ * Write val with the given number of decimals, e.g. -1250 with 2 decimals is
+ * "-12.50". Returns the snprintk() result.
+ */
+int app_fixed_format(char *buf, size_t len, int32_t val, uint8_t decimals);
+
+/** Round a float to fixed-point, saturating at the int32_t range. */
+int32_t app_fixed_from_float(float x, uint8_t decimals);
+
+#endif /* __APP_FIXED_H__ */
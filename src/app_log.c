@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_log, LOG_LEVEL_DBG);
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log_backend.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/sys/util.h>
+
+#include "app_log.h"
+
+#define RATELIMIT_INTERVAL_MS (CONFIG_APP_LOG_RATELIMIT_INTERVAL_S * MSEC_PER_SEC)
+
+static struct k_spinlock ratelimit_lock;
+
+static const struct log_backend *cloud_backend(void)
+{
+#ifdef CONFIG_LOG_BACKEND_GOLIOTH
+	return log_backend_get_by_name("log_backend_golioth");
+#else
+	return NULL;
+#endif
+}
+
+static bool backend_targeted(const struct log_backend *backend, enum app_log_target target)
+{
+	bool is_cloud = (backend == cloud_backend());
+
+	switch (target) {
+	case APP_LOG_TARGET_LOCAL:
+		return !is_cloud;
+	case APP_LOG_TARGET_CLOUD:
+		return is_cloud;
+	default:
+		return true;
+	}
+}
+
+/* Runtime level of a source on the first local backend */
+static uint8_t local_level(uint32_t source_id)
+{
+	for (int i = 0; i < log_backend_count_get(); i++) {
+		const struct log_backend *backend = log_backend_get(i);
+
+		if (backend != cloud_backend()) {
+			return log_filter_get(backend, 0, source_id, true);
+		}
+	}
+
+	return LOG_LEVEL_DBG;
+}
+
+int app_log_level_set(enum app_log_target target, const char *module, uint8_t level)
+{
+	int changed = 0;
+
+	if ((target == APP_LOG_TARGET_CLOUD) && (cloud_backend() == NULL)) {
+		return -ENODEV;
+	}
+
+	for (uint32_t id = 0; id < log_src_cnt_get(0); id++) {
+		const char *name = log_source_name_get(0, id);
+
+		if ((module != NULL) && ((name == NULL) || (strcmp(name, module) != 0))) {
+			continue;
+		}
+
+		for (int i = 0; i < log_backend_count_get(); i++) {
+			const struct log_backend *backend = log_backend_get(i);
+
+			if (backend_targeted(backend, target)) {
+				log_filter_set(backend, 0, id, level);
+			}
+		}
+		changed++;
+	}
+
+	return ((module != NULL) && (changed == 0)) ? -ENOENT : changed;
+}
+
+void app_log_init(void)
+{
+	const struct log_backend *cloud = cloud_backend();
+
+	if (cloud == NULL) {
+		return;
+	}
+
+	/* Modules quietened locally, e.g. the CoAP client in main(), stay quiet in the cloud */
+	for (uint32_t id = 0; id < log_src_cnt_get(0); id++) {
+		log_filter_set(cloud, 0, id, MIN(CONFIG_APP_LOG_CLOUD_LEVEL, local_level(id)));
+	}
+
+	LOG_INF("Cloud log level: %d", CONFIG_APP_LOG_CLOUD_LEVEL);
+}
+
+bool app_log_ratelimit(struct app_log_ratelimit *rl, uint32_t *suppressed)
+{
+	int64_t now = k_uptime_get();
+	bool allowed = false;
+
+	*suppressed = 0;
+
+	K_SPINLOCK(&ratelimit_lock) {
+		if ((rl->count == 0) || (now - rl->window_start_ms >= RATELIMIT_INTERVAL_MS)) {
+			rl->window_start_ms = now;
+			rl->count = 0;
+		}
+
+		if (rl->count < CONFIG_APP_LOG_RATELIMIT_BURST) {
+			rl->count++;
+			*suppressed = rl->suppressed;
+			rl->suppressed = 0;
+			allowed = true;
+		} else {
+			rl->suppressed++;
+		}
+	}
+
+	return allowed;
+}
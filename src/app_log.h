@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_LOG_H__
+#define __APP_LOG_H__
+
+/** Log policy.
+ *
+ * Every message that passes the Golioth log backend filter is sent over the
+ * cellular link, so the cloud gets its own runtime level per module, separate
+ * from the local backends (UART, RTT). By default only warnings and errors
+ * are sent, see `CONFIG_APP_LOG_CLOUD_LEVEL`; the `set_log_level` RPC changes
+ * either side.
+ *
+ * Messages that may repeat on every poll are logged with the APP_LOG_*_RL()
+ * macros. Each call site may log `CONFIG_APP_LOG_RATELIMIT_BURST` messages per
+ * `CONFIG_APP_LOG_RATELIMIT_INTERVAL_S` window; further messages are dropped
+ * and their number is logged with the first message of a later window.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/logging/log.h>
+
+enum app_log_target {
+	/* Every backend */
+	APP_LOG_TARGET_ALL,
+	/* Every backend except the Golioth log backend */
+	APP_LOG_TARGET_LOCAL,
+	/* The Golioth log backend */
+	APP_LOG_TARGET_CLOUD,
+};
+
+struct app_log_ratelimit {
+	int64_t window_start_ms;
+	uint32_t count;
+	uint32_t suppressed;
+};
+
+/**
+ * Apply `CONFIG_APP_LOG_CLOUD_LEVEL` to the Golioth log backend. Call after
+ * golioth_client_create(), which enables the backend and resets its filters.
+ */
+void app_log_init(void);
+
+/**
+ * Set the runtime level of a log module, or of every module if module is NULL.
+ * The level of a module cannot be raised above the one it was built with.
+ *
+ * @return the number of modules changed, -ENOENT if the module does not exist
+ * or -ENODEV if the cloud is targeted without a Golioth log backend.
+ */
+int app_log_level_set(enum app_log_target target, const char *module, uint8_t level);
+
+/**
+ * Count a message against the rate limit of its call site.
+ *
+ * @param suppressed set to the number of messages dropped since the last one
+ * that was allowed, if any
+ *
+ * @return true if the message should be logged
+ */
+bool app_log_ratelimit(struct app_log_ratelimit *rl, uint32_t *suppressed);
+
+#define APP_LOG_RL(_log, ...)                                                                      \
+	do {                                                                                       \
+		static struct app_log_ratelimit _app_log_rl;                                       \
+		uint32_t _app_log_suppressed;                                                      \
+                                                                                                   \
+		if (app_log_ratelimit(&_app_log_rl, &_app_log_suppressed)) {                       \
+			if (_app_log_suppressed) {                                                 \
+				LOG_WRN("%u similar messages suppressed", _app_log_suppressed);    \
+			}                                                                          \
+			_log(__VA_ARGS__);                                                         \
+		}                                                                                  \
+	} while (0)
+
+#define APP_LOG_ERR_RL(...) APP_LOG_RL(LOG_ERR, __VA_ARGS__)
+#define APP_LOG_WRN_RL(...) APP_LOG_RL(LOG_WRN, __VA_ARGS__)
+#define APP_LOG_INF_RL(...) APP_LOG_RL(LOG_INF, __VA_ARGS__)
+
+#endif /* __APP_LOG_H__ */
@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_queue, LOG_LEVEL_DBG);
+
+#include <zephyr/fs/fcb.h>
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/storage/flash_map.h>
+
+#include "app_queue.h"
+
+#define QUEUE_PARTITION_ID FIXED_PARTITION_ID(sensor_queue)
+#define QUEUE_FCB_MAGIC	   0x51564d52 /* "QMVR", bumped when the record layout changes */
+#define QUEUE_FCB_VERSION  1
+
+#define QUEUE_SETTINGS_ROOT    "app/queue"
+#define QUEUE_SETTINGS_DRAINED "drained"
+
+/* Flash writes must be a multiple of the write block size (4 bytes on nRF91) */
+BUILD_ASSERT((sizeof(struct app_queue_record) % 4) == 0);
+
+static struct fcb fcb;
+static struct flash_sector sectors[CONFIG_APP_QUEUE_MAX_SECTORS];
+static K_MUTEX_DEFINE(queue_lock);
+static bool ready;
+
+/* Last entry handed out by app_queue_pop(), fe_sector is NULL before the first one */
+static struct fcb_entry drain_loc;
+
+static uint32_t next_seq = 1;
+static uint32_t drained_seq;
+static uint32_t saved_drained_seq;
+
+static struct app_queue_stats stats;
+
+static int queue_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+	const char *next;
+	ssize_t rc;
+
+	if (settings_name_steq(name, QUEUE_SETTINGS_DRAINED, &next) && !next) {
+		if (len != sizeof(drained_seq)) {
+			return -EINVAL;
+		}
+
+		rc = read_cb(cb_arg, &drained_seq, sizeof(drained_seq));
+		if (rc < 0) {
+			return rc;
+		}
+
+		saved_drained_seq = drained_seq;
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_queue, QUEUE_SETTINGS_ROOT, NULL, queue_settings_set, NULL,
+			       NULL);
+
+static int record_read(const struct fcb_entry *loc, struct app_queue_record *record)
+{
+	if (loc->fe_data_len != sizeof(*record)) {
+		return -EBADMSG;
+	}
+
+	return flash_area_read(fcb.fap, FCB_ENTRY_FA_DATA_OFF((*loc)), record, sizeof(*record));
+}
+
+/* Step loc to the next record that has not been drained yet */
+static int next_pending(struct fcb_entry *loc, struct app_queue_record *record)
+{
+	int err;
+
+	while (fcb_getnext(&fcb, loc) == 0) {
+		err = record_read(loc, record);
+		if (err) {
+			LOG_WRN("Skipping unreadable queue record: %d", err);
+			continue;
+		}
+
+		if (record->seq > drained_seq) {
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+static int count_pending_cb(struct fcb_entry_ctx *loc_ctx, void *arg)
+{
+	struct app_queue_record record;
+	uint32_t *count = arg;
+
+	if (record_read(&loc_ctx->loc, &record) != 0) {
+		return 0;
+	}
+
+	if (record.seq >= next_seq) {
+		next_seq = record.seq + 1;
+	}
+
+	if (record.seq > drained_seq) {
+		(*count)++;
+	}
+
+	return 0;
+}
+
+int app_queue_init(void)
+{
+	uint32_t sector_cnt = ARRAY_SIZE(sectors);
+	const struct flash_area *fa;
+	int err;
+
+	err = settings_load_subtree(QUEUE_SETTINGS_ROOT);
+	if (err) {
+		LOG_WRN("Failed to load queue settings: %d", err);
+	}
+
+	err = flash_area_get_sectors(QUEUE_PARTITION_ID, &sector_cnt, sectors);
+	if (err) {
+		LOG_ERR("Failed to get queue partition sectors: %d", err);
+		return err;
+	}
+
+	fcb.f_magic = QUEUE_FCB_MAGIC;
+	fcb.f_version = QUEUE_FCB_VERSION;
+	fcb.f_sector_cnt = sector_cnt;
+	fcb.f_scratch_cnt = 0;
+	fcb.f_sectors = sectors;
+
+	err = fcb_init(QUEUE_PARTITION_ID, &fcb);
+	if (err) {
+		LOG_WRN("Queue partition invalid (%d), erasing", err);
+
+		err = flash_area_open(QUEUE_PARTITION_ID, &fa);
+		if (err) {
+			return err;
+		}
+		err = flash_area_erase(fa, 0, fa->fa_size);
+		flash_area_close(fa);
+		if (err) {
+			return err;
+		}
+
+		err = fcb_init(QUEUE_PARTITION_ID, &fcb);
+		if (err) {
+			LOG_ERR("Failed to initialize queue: %d", err);
+			return err;
+		}
+	}
+
+	next_seq = drained_seq + 1;
+	fcb_walk(&fcb, NULL, count_pending_cb, &stats.pending);
+
+	ready = true;
+
+	LOG_INF("Flash queue ready: %u sectors, %u records pending", sector_cnt, stats.pending);
+
+	return 0;
+}
+
+int app_queue_append(struct app_queue_record *record)
+{
+	struct fcb_entry loc;
+	uint32_t lost = 0;
+	int err;
+
+	if (!ready) {
+		return -ENODEV;
+	}
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	record->seq = next_seq;
+
+	err = fcb_append(&fcb, sizeof(*record), &loc);
+	if (err == -ENOSPC) {
+		/* Full, make room by discarding the oldest sector */
+		fcb_walk(&fcb, fcb.f_oldest, count_pending_cb, &lost);
+
+		if (drain_loc.fe_sector == fcb.f_oldest) {
+			drain_loc.fe_sector = NULL;
+		}
+
+		err = fcb_rotate(&fcb);
+		if (!err) {
+			stats.dropped += lost;
+			stats.pending -= MIN(lost, stats.pending);
+			LOG_WRN("Flash queue full, %u records dropped", lost);
+
+			err = fcb_append(&fcb, sizeof(*record), &loc);
+		}
+	}
+
+	if (err) {
+		LOG_ERR("Failed to append to flash queue: %d", err);
+		stats.dropped++;
+		goto unlock;
+	}
+
+	err = flash_area_write(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), record, sizeof(*record));
+	if (err) {
+		LOG_ERR("Failed to write flash queue record: %d", err);
+		stats.dropped++;
+		goto unlock;
+	}
+
+	err = fcb_append_finish(&fcb, &loc);
+	if (err) {
+		LOG_ERR("Failed to finish flash queue record: %d", err);
+		stats.dropped++;
+		goto unlock;
+	}
+
+	next_seq++;
+	stats.queued++;
+	stats.pending++;
+
+unlock:
+	k_mutex_unlock(&queue_lock);
+
+	return err;
+}
+
+int app_queue_peek(struct app_queue_record *records, size_t max_count, size_t *count)
+{
+	struct fcb_entry loc;
+
+	if (!ready) {
+		return -ENODEV;
+	}
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	loc = drain_loc;
+	*count = 0;
+
+	while ((*count < max_count) && (next_pending(&loc, &records[*count]) == 0)) {
+		(*count)++;
+	}
+
+	k_mutex_unlock(&queue_lock);
+
+	return 0;
+}
+
+int app_queue_pop(uint32_t seq)
+{
+	struct app_queue_record record;
+	struct fcb_entry loc;
+
+	if (!ready) {
+		return -ENODEV;
+	}
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	/* drain_loc may have been reset by a rotation since the records were peeked, so stop
+	 * at the sequence number instead of counting records
+	 */
+	loc = drain_loc;
+	while ((next_pending(&loc, &record) == 0) && (record.seq <= seq)) {
+		drain_loc = loc;
+		stats.drained++;
+		stats.pending -= MIN(1, stats.pending);
+	}
+
+	/* Records of the upload that a rotation erased were counted as dropped */
+	if (seq > drained_seq) {
+		drained_seq = seq;
+	}
+
+	/* Erase sectors whose records have all been drained */
+	while ((drain_loc.fe_sector != NULL) && (fcb.f_oldest != drain_loc.fe_sector) &&
+	       (fcb.f_oldest != fcb.f_active.fe_sector)) {
+		if (fcb_rotate(&fcb)) {
+			break;
+		}
+	}
+
+	k_mutex_unlock(&queue_lock);
+
+	return 0;
+}
+
+void app_queue_drain_done(void)
+{
+	int err;
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	if (drained_seq != saved_drained_seq) {
+		err = settings_save_one(QUEUE_SETTINGS_ROOT "/" QUEUE_SETTINGS_DRAINED, &drained_seq,
+					sizeof(drained_seq));
+		if (err) {
+			LOG_WRN("Failed to save drained queue position: %d", err);
+		} else {
+			saved_drained_seq = drained_seq;
+		}
+	}
+
+	k_mutex_unlock(&queue_lock);
+
+	LOG_INF("Flash queue: %u queued, %u dropped, %u drained, %u pending", stats.queued,
+		stats.dropped, stats.drained, stats.pending);
+}
+
+size_t app_queue_pending(void)
+{
+	return stats.pending;
+}
+
+void app_queue_stats_get(struct app_queue_stats *out)
+{
+	k_mutex_lock(&queue_lock, K_FOREVER);
+	*out = stats;
+	k_mutex_unlock(&queue_lock);
+}
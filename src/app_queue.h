@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_QUEUE_H__
+#define __APP_QUEUE_H__
+
+/** Flash-backed store-and-forward queue for measurements taken while offline.
+ *
+ * Records hold the raw QM30VT2 alias register block and are appended to a
+ * flash circular buffer (FCB) on the `sensor_queue` partition. The FCB only
+ * ever appends and erases whole sectors, which spreads wear across the
+ * partition. When the partition is full the oldest sector is erased and its
+ * records are counted as dropped.
+ *
+ * Records are read back in order with app_queue_peek() and released up to the
+ * sequence number of the last one uploaded with app_queue_pop(), so records
+ * appended or dropped meanwhile are not released by mistake. The sequence number of the last released record is saved
+ * to settings at the end of each drain so records are not sent twice after
+ * a reboot.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "qm30vt2.h"
+
+struct app_queue_record {
+	uint32_t seq;
+	/* Bitmask of the metrics to upload */
+	uint32_t metrics;
+	/* Unix time in milliseconds, 0 if the wall clock was not available */
+	int64_t ts_ms;
+	uint8_t unit_id;
+	uint8_t reserved[3];
+	uint16_t holding_reg[QM30VT2_ALIAS_SIZE];
+};
+
+struct app_queue_stats {
+	uint32_t queued;
+	uint32_t dropped;
+	uint32_t drained;
+	uint32_t pending;
+};
+
+int app_queue_init(void);
+int app_queue_append(struct app_queue_record *record);
+int app_queue_peek(struct app_queue_record *records, size_t max_count, size_t *count);
+int app_queue_pop(uint32_t seq);
+void app_queue_drain_done(void);
+size_t app_queue_pending(void);
+void app_queue_stats_get(struct app_queue_stats *stats);
+
+#endif /* __APP_QUEUE_H__ */
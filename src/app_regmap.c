@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_regmap, LOG_LEVEL_DBG);
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/modbus/modbus.h>
+
+#include "app_fixed.h"
+#include "app_log.h"
+#include "app_regmap.h"
+#include "qm30vt2.h"
+
+/* Registers of the largest map, if every field is 32 bits wide */
+#define REGMAP_REQS_MAX (2 * CONFIG_APP_REGMAP_MAX_FIELDS)
+
+/* Decode step of one field */
+struct regmap_op {
+	uint8_t type;
+	uint8_t decimals;
+	/* Index of the high and low word in the read buffer, only the first for 16 bits */
+	uint16_t off[2];
+};
+
+/* A map compiled for polling */
+struct regmap_plan {
+	struct app_regmap map;
+	struct qm30vt2_xfer xfers[REGMAP_REQS_MAX];
+	size_t xfer_count;
+	/* Registers read by all transactions, including gaps */
+	uint16_t reg_count;
+	struct regmap_op ops[CONFIG_APP_REGMAP_MAX_FIELDS];
+};
+
+static const char *const type_names[APP_REGMAP_TYPE_COUNT] = {
+	[APP_REGMAP_U16] = "u16", [APP_REGMAP_S16] = "s16", [APP_REGMAP_U32] = "u32",
+	[APP_REGMAP_S32] = "s32", [APP_REGMAP_F32] = "f32",
+};
+
+static K_MUTEX_DEFINE(regmap_lock);
+
+static struct regmap_plan active;
+
+/* Only used by app_regmap_set(), which is not reentrant */
+static struct regmap_plan staging;
+
+/* Copy of the active plan and its transactions, back to back; only used by the acquisition
+ * thread, so Modbus I/O runs without regmap_lock
+ */
+static struct regmap_plan polling;
+static uint16_t read_buf[CONFIG_APP_REGMAP_MAX_REGS];
+
+static inline size_t type_regs(uint8_t type)
+{
+	return (type >= APP_REGMAP_U32) ? 2 : 1;
+}
+
+int app_regmap_type_parse(const char *str)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(type_names); i++) {
+		if (strcmp(str, type_names[i]) == 0) {
+			return i;
+		}
+	}
+
+	return -EINVAL;
+}
+
+/* Names become keys of stream records, so they are limited to [A-Za-z0-9_-] */
+static bool regmap_name_valid(const char *name)
+{
+	size_t len = strnlen(name, APP_REGMAP_NAME_LEN);
+
+	if ((len == 0) || (len == APP_REGMAP_NAME_LEN)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		if (!isalnum((unsigned char)name[i]) && (name[i] != '_') && (name[i] != '-')) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int regmap_validate(const char *name, const struct app_regmap_field *fields,
+			   size_t count)
+{
+	if (count && ((name == NULL) || !regmap_name_valid(name))) {
+		LOG_ERR("Invalid register map name");
+		return -EINVAL;
+	}
+
+	if (count > CONFIG_APP_REGMAP_MAX_FIELDS) {
+		LOG_ERR("Register map has %zu fields, at most %d are supported", count,
+			CONFIG_APP_REGMAP_MAX_FIELDS);
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		const struct app_regmap_field *field = &fields[i];
+
+		if (!regmap_name_valid(field->name) || (field->type >= APP_REGMAP_TYPE_COUNT) ||
+		    (field->decimals > APP_FIXED_MAX_DECIMALS) ||
+		    (field->addr + type_regs(field->type) - 1 > UINT16_MAX)) {
+			LOG_ERR("Invalid register map field %zu", i);
+			return -EINVAL;
+		}
+
+		for (size_t j = 0; j < i; j++) {
+			if (strcmp(field->name, fields[j].name) == 0) {
+				LOG_ERR("Duplicate register map field \"%s\"", field->name);
+				return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Index in the read buffer of a register read by the transactions of a plan */
+static uint16_t regmap_offset(const struct regmap_plan *plan, uint16_t addr)
+{
+	uint16_t off = 0;
+
+	for (size_t i = 0; i < plan->xfer_count; i++) {
+		const struct qm30vt2_xfer *xfer = &plan->xfers[i];
+
+		if ((addr >= xfer->addr) && (addr < xfer->addr + xfer->count)) {
+			return off + (addr - xfer->addr);
+		}
+		off += xfer->count;
+	}
+
+	/* Every register of the map is planned */
+	__ASSERT(false, "Register %u not planned", addr);
+
+	return 0;
+}
+
+static int regmap_compile(struct regmap_plan *plan, const struct app_regmap_field *fields,
+			  size_t count)
+{
+	struct qm30vt2_reg_req reqs[REGMAP_REQS_MAX];
+	size_t req_count = 0;
+	int n;
+
+	/* Registers of every field, in address order */
+	for (size_t i = 0; i < count; i++) {
+		for (size_t w = 0; w < type_regs(fields[i].type); w++) {
+			uint16_t addr = fields[i].addr + w;
+			size_t j = req_count++;
+
+			for (; (j > 0) && (reqs[j - 1].addr > addr); j--) {
+				reqs[j] = reqs[j - 1];
+			}
+			reqs[j].addr = addr;
+			reqs[j].dst = NULL;
+		}
+	}
+
+	n = qm30vt2_read_plan(reqs, req_count, CONFIG_APP_QM30VT2_READ_GAP_MAX, plan->xfers,
+			      ARRAY_SIZE(plan->xfers));
+	if (n < 0) {
+		return n;
+	}
+
+	plan->xfer_count = n;
+	plan->reg_count = 0;
+	for (size_t i = 0; i < plan->xfer_count; i++) {
+		plan->reg_count += plan->xfers[i].count;
+	}
+
+	if (plan->reg_count > ARRAY_SIZE(read_buf)) {
+		LOG_ERR("Register map reads %u registers, at most %zu are supported",
+			plan->reg_count, ARRAY_SIZE(read_buf));
+		return -E2BIG;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		const struct app_regmap_field *field = &fields[i];
+		struct regmap_op *op = &plan->ops[i];
+		uint16_t first = regmap_offset(plan, field->addr);
+
+		op->type = field->type;
+		op->decimals = field->decimals;
+		op->off[0] = first;
+
+		if (type_regs(field->type) == 2) {
+			uint16_t second = regmap_offset(plan, field->addr + 1);
+
+			/* Swapping is resolved here, so decoding does not branch on it */
+			op->off[0] = field->swap ? second : first;
+			op->off[1] = field->swap ? first : second;
+		}
+	}
+
+	memcpy(plan->map.fields, fields, count * sizeof(*fields));
+	plan->map.field_count = count;
+
+	return 0;
+}
+
+int app_regmap_set(const char *name, const struct app_regmap_field *fields, size_t count)
+{
+	int err;
+
+	err = regmap_validate(name, fields, count);
+	if (err) {
+		return err;
+	}
+
+	memset(&staging, 0, sizeof(staging));
+
+	if (count) {
+		err = regmap_compile(&staging, fields, count);
+		if (err) {
+			return err;
+		}
+		strncpy(staging.map.name, name, sizeof(staging.map.name) - 1);
+	}
+
+	k_mutex_lock(&regmap_lock, K_FOREVER);
+
+	staging.map.generation = active.map.generation + 1;
+	active = staging;
+
+	k_mutex_unlock(&regmap_lock);
+
+	if (count) {
+		LOG_INF("Register map \"%s\": %zu fields, %u registers in %zu transactions",
+			active.map.name, count, active.reg_count, active.xfer_count);
+	} else {
+		LOG_INF("Register map removed");
+	}
+
+	return 0;
+}
+
+static void regmap_decode(const struct regmap_plan *plan, const uint16_t *regs,
+			  struct app_regmap_sample *sample)
+{
+	for (size_t i = 0; i < plan->map.field_count; i++) {
+		const struct regmap_op *op = &plan->ops[i];
+		uint32_t raw = regs[op->off[0]];
+		float f;
+
+		switch (op->type) {
+		case APP_REGMAP_U16:
+			sample->val[i] = raw;
+			break;
+		case APP_REGMAP_S16:
+			sample->val[i] = (int16_t)raw;
+			break;
+		case APP_REGMAP_U32:
+			raw = (raw << 16) | regs[op->off[1]];
+			sample->val[i] = MIN(raw, (uint32_t)INT32_MAX);
+			break;
+		case APP_REGMAP_S32:
+			sample->val[i] = (int32_t)((raw << 16) | regs[op->off[1]]);
+			break;
+		case APP_REGMAP_F32:
+			raw = (raw << 16) | regs[op->off[1]];
+			memcpy(&f, &raw, sizeof(f));
+			/* NaN, which some sensors report for a missing value, reads as 0 */
+			sample->val[i] = isnan(f) ? 0 : app_fixed_from_float(f, op->decimals);
+			break;
+		}
+	}
+
+	sample->generation = plan->map.generation;
+	sample->count = plan->map.field_count;
+}
+
+int app_regmap_decode(const uint16_t *regs, struct app_regmap_sample *sample)
+{
+	int err = 0;
+
+	k_mutex_lock(&regmap_lock, K_FOREVER);
+
+	if (active.map.field_count) {
+		regmap_decode(&active, regs, sample);
+	} else {
+		err = -ENOENT;
+	}
+
+	k_mutex_unlock(&regmap_lock);
+
+	return err;
+}
+
+int app_regmap_read(const int iface, uint8_t unit_id, struct app_regmap_sample *sample)
+{
+	uint16_t off = 0;
+	int err = 0;
+
+	k_mutex_lock(&regmap_lock, K_FOREVER);
+
+	if (polling.map.generation != active.map.generation) {
+		polling = active;
+	}
+
+	k_mutex_unlock(&regmap_lock);
+
+	if (polling.map.field_count == 0) {
+		return -ENOENT;
+	}
+
+	for (size_t i = 0; (i < polling.xfer_count) && !err; i++) {
+		const struct qm30vt2_xfer *xfer = &polling.xfers[i];
+
+		err = modbus_read_holding_regs(iface, unit_id, xfer->addr, &read_buf[off],
+					       xfer->count);
+		if (err) {
+			APP_LOG_ERR_RL("Modbus FC03 of %u registers at %u failed with %d",
+				       xfer->count, xfer->addr, err);
+		}
+		off += xfer->count;
+	}
+
+	if (!err) {
+		regmap_decode(&polling, read_buf, sample);
+	}
+
+	return err;
+}
+
+int app_regmap_get(uint16_t generation, struct app_regmap *map)
+{
+	int err = 0;
+
+	k_mutex_lock(&regmap_lock, K_FOREVER);
+
+	if ((active.map.field_count == 0) || (active.map.generation != generation)) {
+		err = -ESTALE;
+	} else {
+		*map = active.map;
+	}
+
+	k_mutex_unlock(&regmap_lock);
+
+	return err;
+}
+
+int app_regmap_to_json(char *buf, size_t len)
+{
+	int ret;
+
+	k_mutex_lock(&regmap_lock, K_FOREVER);
+
+	if (active.map.field_count) {
+		ret = snprintk(buf, len,
+			       "{\"name\":\"%s\",\"generation\":%u,\"fields\":%zu,"
+			       "\"registers\":%u,\"transactions\":%zu}",
+			       active.map.name, active.map.generation, active.map.field_count,
+			       active.reg_count, active.xfer_count);
+	} else {
+		ret = snprintk(buf, len, "null");
+	}
+
+	k_mutex_unlock(&regmap_lock);
+
+	return ((ret < 0) || (ret >= len)) ? -ENOMEM : ret;
+}
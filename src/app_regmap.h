@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_REGMAP_H__
+#define __APP_REGMAP_H__
+
+/** Generic Modbus register map.
+ *
+ * Units flagged with `"regmap": true` in the `units` array of the desired
+ * LightDB State are polled with a register map pushed to the `regmap` LightDB
+ * State path instead of the QM30VT2 driver, so other sensors can be read
+ * without a new driver or firmware. Each field of the map names a value, its
+ * holding register address, data type and decimals, e.g.:
+ *
+ *   {"name": "pump", "fields": [
+ *     {"name": "temp", "addr": 5203, "type": "s16", "dec": 2},
+ *     {"name": "flow", "addr": 100, "type": "f32", "dec": 3, "swap": true}]}
+ *
+ * A new map is validated and compiled as a whole: its registers are grouped
+ * into as few transactions as qm30vt2_read_plan() allows, and each field into
+ * a decode step that points at its registers in the buffer those transactions
+ * are read into. A poll then only runs the transactions and the decode steps,
+ * without looking up addresses. An invalid map is rejected and the previous one
+ * stays in use.
+ *
+ * Values are kept as fixed-point (see app_fixed.h) with the decimals of their
+ * field: integer registers are taken as is, floats are rounded to the decimals.
+ * Unsigned 32-bit values saturate at INT32_MAX.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Longest map or field name, with its terminator */
+#define APP_REGMAP_NAME_LEN 16
+
+enum app_regmap_type {
+	APP_REGMAP_U16,
+	APP_REGMAP_S16,
+	/* 32-bit types span two registers, high word first unless swapped */
+	APP_REGMAP_U32,
+	APP_REGMAP_S32,
+	/* IEEE 754 single precision */
+	APP_REGMAP_F32,
+	APP_REGMAP_TYPE_COUNT,
+};
+
+struct app_regmap_field {
+	char name[APP_REGMAP_NAME_LEN];
+	/* 0-based holding register address of the first register */
+	uint16_t addr;
+	uint8_t type;
+	/* The register holds the value × 10^decimals, or floats are rounded to these */
+	uint8_t decimals;
+	/* Low word in the first register */
+	bool swap;
+};
+
+struct app_regmap {
+	char name[APP_REGMAP_NAME_LEN];
+	/* Changes with every map that is applied */
+	uint16_t generation;
+	size_t field_count;
+	struct app_regmap_field fields[CONFIG_APP_REGMAP_MAX_FIELDS];
+};
+
+/* Values of one poll, in field order */
+struct app_regmap_sample {
+	uint8_t unit_id;
+	/* Generation of the map the values were decoded with */
+	uint16_t generation;
+	uint8_t count;
+	/* k_uptime_get() when the poll completed */
+	int64_t uptime_ms;
+	int32_t val[CONFIG_APP_REGMAP_MAX_FIELDS];
+};
+
+/** Data type from its name: "u16", "s16", "u32", "s32" or "f32", -EINVAL if unknown. */
+int app_regmap_type_parse(const char *str);
+
+/**
+ * Validate and compile a register map, then use it for the following polls. A
+ * map without fields removes the current one.
+ *
+ * @return 0 on success, -EINVAL if a field is invalid, -E2BIG if the map needs
+ * more than CONFIG_APP_REGMAP_MAX_REGS registers.
+ */
+int app_regmap_set(const char *name, const struct app_regmap_field *fields, size_t count);
+
+/**
+ * Read and decode the map from a unit, called by the acquisition thread. The
+ * transactions run on a copy of the map taken when it was applied, so a new
+ * map can be set while a poll is under way.
+ *
+ * @return 0 on success, -ENOENT without a map, otherwise the error of the
+ * Modbus client.
+ */
+int app_regmap_read(const int iface, uint8_t unit_id, struct app_regmap_sample *sample);
+
+/**
+ * Decode registers laid out as the transactions of the current map read them,
+ * back to back. Used by app_regmap_read() and the benchmark.
+ */
+int app_regmap_decode(const uint16_t *regs, struct app_regmap_sample *sample);
+
+/**
+ * Copy the current map if it is still the one of the given generation.
+ *
+ * @return 0 on success, -ESTALE if the map was changed or removed since.
+ */
+int app_regmap_get(uint16_t generation, struct app_regmap *map);
+
+/** Describe the current map as a JSON object for LightDB State, "null" if none. */
+int app_regmap_to_json(char *buf, size_t len);
+
+#endif /* __APP_REGMAP_H__ */
@@ -9,15 +9,25 @@ LOG_MODULE_REGISTER(app_rpc, LOG_LEVEL_DBG);
 
 #include <golioth/client.h>
 #include <golioth/rpc.h>
-#include <zephyr/logging/log_ctrl.h>
+#include <string.h>
 #include <zephyr/sys/reboot.h>
 
 #ifdef CONFIG_NETWORK_INFO
 #include <network_info.h>
 #endif
 
+#include "app_acq.h"
+#include "app_bus.h"
+#include "app_log.h"
 #include "app_rpc.h"
 
+/* Registers returned by one read_registers call */
+#define RPC_READ_MAX_REGS 32
+/* Wait for polls and other requests ahead in the acquisition queue */
+#define RPC_READ_TIMEOUT K_SECONDS(5)
+/* Longest log module name accepted by set_log_level */
+#define RPC_LOG_MODULE_MAX_LEN 48
+
 static void reboot_work_handler(struct k_work *work)
 {
 	for (int8_t i = 5; i >= 0; i--) {
@@ -43,12 +53,114 @@ static enum golioth_rpc_status on_get_network_info(zcbor_state_t *request_params
 		    (return GOLIOTH_RPC_UNIMPLEMENTED););
 }
 
+static enum golioth_rpc_status on_get_modbus_stats(zcbor_state_t *request_params_array,
+						   zcbor_state_t *response_detail_map,
+						   void *callback_arg)
+{
+	uint8_t unit_id = 0;
+	double param_0;
+	int err;
+
+	/* Without a parameter, the totals of all units are returned */
+	if (zcbor_float_decode(request_params_array, &param_0)) {
+		if ((param_0 < APP_BUS_UNIT_ID_MIN) || (param_0 > APP_BUS_UNIT_ID_MAX)) {
+			LOG_ERR("Requested unit is out of bounds: %d", (int)param_0);
+			return GOLIOTH_RPC_INVALID_ARGUMENT;
+		}
+		unit_id = (uint8_t)param_0;
+	}
+
+	err = app_bus_diag_encode(response_detail_map, unit_id);
+	if (err == -ENOENT) {
+		LOG_ERR("Unit %u is not polled", unit_id);
+		return GOLIOTH_RPC_NOT_FOUND;
+	}
+	if (err) {
+		LOG_ERR("Failed to encode Modbus stats: %d", err);
+		return GOLIOTH_RPC_RESOURCE_EXHAUSTED;
+	}
+
+	return GOLIOTH_RPC_OK;
+}
+
+static enum golioth_rpc_status on_read_registers(zcbor_state_t *request_params_array,
+						 zcbor_state_t *response_detail_map,
+						 void *callback_arg)
+{
+	uint16_t regs[RPC_READ_MAX_REGS];
+	double unit_id, addr, count;
+	bool ok;
+	int err;
+
+	ok = zcbor_float_decode(request_params_array, &unit_id) &&
+	     zcbor_float_decode(request_params_array, &addr) &&
+	     zcbor_float_decode(request_params_array, &count);
+	if (!ok) {
+		LOG_ERR("Expected unit ID, register address and count");
+		return GOLIOTH_RPC_INVALID_ARGUMENT;
+	}
+
+	if ((unit_id < APP_BUS_UNIT_ID_MIN) || (unit_id > APP_BUS_UNIT_ID_MAX) || (addr < 0) ||
+	    (count < 1) || (count > RPC_READ_MAX_REGS) || (addr + count > UINT16_MAX + 1)) {
+		LOG_ERR("Requested registers are out of bounds");
+		return GOLIOTH_RPC_INVALID_ARGUMENT;
+	}
+
+	/* Serviced by the acquisition thread ahead of pending polls */
+	err = app_acq_read((uint8_t)unit_id, (uint16_t)addr, regs, (uint16_t)count,
+			   RPC_READ_TIMEOUT);
+	if (err) {
+		LOG_ERR("Failed to read registers of unit %u: %d", (uint8_t)unit_id, err);
+	}
+	if (err == -EAGAIN) {
+		return GOLIOTH_RPC_UNAVAILABLE;
+	}
+	if (err == -ETIMEDOUT) {
+		return GOLIOTH_RPC_DEADLINE_EXCEEDED;
+	}
+	if (err) {
+		/* Modbus exceptions are positive */
+		return (err > 0) ? GOLIOTH_RPC_FAILED_PRECONDITION : GOLIOTH_RPC_INTERNAL;
+	}
+
+	ok = zcbor_tstr_put_lit(response_detail_map, "registers") &&
+	     zcbor_list_start_encode(response_detail_map, RPC_READ_MAX_REGS);
+	for (size_t i = 0; ok && (i < (uint16_t)count); i++) {
+		ok = zcbor_uint32_put(response_detail_map, regs[i]);
+	}
+	ok = ok && zcbor_list_end_encode(response_detail_map, RPC_READ_MAX_REGS);
+
+	return ok ? GOLIOTH_RPC_OK : GOLIOTH_RPC_RESOURCE_EXHAUSTED;
+}
+
+static int rpc_log_target_decode(const struct zcbor_string *str, enum app_log_target *target)
+{
+	static const char *const names[] = {
+		[APP_LOG_TARGET_ALL] = "all",
+		[APP_LOG_TARGET_LOCAL] = "local",
+		[APP_LOG_TARGET_CLOUD] = "cloud",
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(names); i++) {
+		if ((str->len == strlen(names[i])) && (memcmp(str->value, names[i], str->len) == 0)) {
+			*target = i;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
 static enum golioth_rpc_status on_set_log_level(zcbor_state_t *request_params_array,
 						zcbor_state_t *response_detail_map,
 						void *callback_arg)
 {
+	enum app_log_target target = APP_LOG_TARGET_ALL;
+	char module[RPC_LOG_MODULE_MAX_LEN + 1];
+	struct zcbor_string str;
 	double param_0;
 	uint8_t log_level;
+	int changed;
 	bool ok;
 
 	LOG_WRN("on_set_log_level");
@@ -59,33 +171,47 @@ static enum golioth_rpc_status on_set_log_level(zcbor_state_t *request_params_ar
 		return GOLIOTH_RPC_INVALID_ARGUMENT;
 	}
 
-	log_level = (uint8_t)param_0;
+	if ((param_0 < LOG_LEVEL_NONE) || (param_0 > LOG_LEVEL_DBG)) {
+		LOG_ERR("Requested log level is out of bounds: %d", (int)param_0);
+		return GOLIOTH_RPC_INVALID_ARGUMENT;
+	}
 
-	if ((log_level < 0) || (log_level > LOG_LEVEL_DBG)) {
+	log_level = (uint8_t)param_0;
 
-		LOG_ERR("Requested log level is out of bounds: %d", log_level);
+	/* Optional target, "all" (default), "local" or "cloud" */
+	if (zcbor_tstr_decode(request_params_array, &str) &&
+	    rpc_log_target_decode(&str, &target)) {
+		LOG_ERR("Unknown log target: %.*s", (int)str.len, str.value);
 		return GOLIOTH_RPC_INVALID_ARGUMENT;
 	}
 
-	int source_id = 0;
-	char *source_name;
-
-	while (1) {
-		source_name = (char *)log_source_name_get(0, source_id);
-		if (source_name == NULL) {
-			break;
+	/* Optional module name, all modules by default */
+	module[0] = '\0';
+	if (zcbor_tstr_decode(request_params_array, &str)) {
+		if (str.len >= sizeof(module)) {
+			LOG_ERR("Log module name too long");
+			return GOLIOTH_RPC_INVALID_ARGUMENT;
 		}
+		memcpy(module, str.value, str.len);
+		module[str.len] = '\0';
+	}
 
-		log_filter_set(NULL, 0, source_id, log_level);
-		++source_id;
+	changed = app_log_level_set(target, module[0] ? module : NULL, log_level);
+	if (changed == -ENOENT) {
+		LOG_ERR("Unknown log module: %s", module);
+		return GOLIOTH_RPC_NOT_FOUND;
+	}
+	if (changed == -ENODEV) {
+		LOG_ERR("Golioth log backend not available");
+		return GOLIOTH_RPC_UNAVAILABLE;
 	}
 
-	LOG_WRN("Log levels for %d modules set to: %d", source_id, log_level);
+	LOG_WRN("Log levels for %d modules set to: %d", changed, log_level);
 
 	ok = zcbor_tstr_put_lit(response_detail_map, "log_modules") &&
-	     zcbor_float64_put(response_detail_map, (double)source_id);
+	     zcbor_float64_put(response_detail_map, (double)changed);
 
-	return GOLIOTH_RPC_OK;
+	return ok ? GOLIOTH_RPC_OK : GOLIOTH_RPC_RESOURCE_EXHAUSTED;
 }
 
 static enum golioth_rpc_status on_reboot(zcbor_state_t *request_params_array,
@@ -113,6 +239,12 @@ void app_rpc_register(struct golioth_client *client)
 	err = golioth_rpc_register(rpc, "get_network_info", on_get_network_info, NULL);
 	rpc_log_if_register_failure(err);
 
+	err = golioth_rpc_register(rpc, "get_modbus_stats", on_get_modbus_stats, NULL);
+	rpc_log_if_register_failure(err);
+
+	err = golioth_rpc_register(rpc, "read_registers", on_read_registers, NULL);
+	rpc_log_if_register_failure(err);
+
 	err = golioth_rpc_register(rpc, "reboot", on_reboot, NULL);
 	rpc_log_if_register_failure(err);
 
@@ -10,9 +10,13 @@
  *
  * This demonstration implements the following RPCs:
  * - `get_network_info`: Query and return network information.
+ * - `get_modbus_stats`: return Modbus error counts by cause, a transaction
+ *   latency histogram and loop timing (optional argument: unit ID, default all)
+ * - `read_registers`: read holding registers of any unit on the bus, ahead of
+ *   pending polls (arguments: unit ID, register address, count 1..32)
  * - `reboot`: reboot the device (no arguments)
- * - `set_log_level`: adjust the logging level for all registered modules (valid
- *   argument values: 0..4)
+ * - `set_log_level`: adjust the logging level (argument values: 0..4), optionally
+ *   only for "local" or "cloud" logging (default "all") and a single module name
  *
  * https://docs.golioth.io/firmware/zephyr-device-sdk/remote-procedure-call
  */
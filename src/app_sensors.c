@@ -10,305 +10,1415 @@ LOG_MODULE_REGISTER(app_sensors, LOG_LEVEL_DBG);
 #include <golioth/client.h>
 #include <golioth/stream.h>
 #include <zcbor_encode.h>
-#include <zephyr/drivers/gpio.h>
 #include <zephyr/kernel.h>
-#include <zephyr/modbus/modbus.h>
-#include <zephyr/drivers/sensor.h>
 
+#include "app_acq.h"
+#include "app_adaptive.h"
+#include "app_alarm.h"
+#include "app_batch.h"
+#include "app_boot.h"
+#include "app_bus.h"
+#include "app_display.h"
+#include "app_fixed.h"
+#include "app_log.h"
+#include "app_queue.h"
+#ifdef CONFIG_APP_REGMAP
+#include "app_regmap.h"
+#endif
 #include "app_sensors.h"
+#include "app_settings.h"
+#include "app_state.h"
+#include "app_summary.h"
+#include "app_time.h"
 #include "qm30vt2.h"
 
-#ifdef CONFIG_LIB_OSTENTUS
-#include <libostentus.h>
-static const struct device *o_dev = DEVICE_DT_GET_ANY(golioth_ostentus);
-#endif
-
 #ifdef CONFIG_ALUDEL_BATTERY_MONITOR
 #include <battery_monitor.h>
 #endif
 
-#define ZEPHYR_USER_NODE DT_PATH(zephyr_user)
-#define MODBUS_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(zephyr_modbus_serial)
-
-/* Formatting string for sending sensor JSON to Golioth */
-/* clang-format off */
-#define JSON_FMT \
-"{" \
-	"\"temperature\": {" \
-		"\"celcius\":%f," \
-		"\"farenheight\":%f" \
-	"}," \
-	"\"x_axis\": {" \
-		"\"acceleration\": {" \
-			"\"crest_factor\":%f," \
-			"\"high_frequency_rms\":%f," \
-			"\"kurtosis\":%f," \
-			"\"peak\":%f," \
-			"\"rms\":%f" \
-		"}," \
-		"\"velocity\": {" \
-			"\"peak\": {" \
-				"\"frequency\":%f," \
-				"\"in_per_sec\":%f," \
-				"\"mm_per_sec\":%f" \
-			"}," \
-			"\"rms\": {" \
-				"\"in_per_sec\":%f," \
-				"\"mm_per_sec\":%f" \
-			"}" \
-		"}" \
-	"}," \
-	"\"z_axis\": {" \
-		"\"acceleration\": {" \
-			"\"crest_factor\":%f," \
-			"\"high_frequency_rms\":%f," \
-			"\"kurtosis\":%f," \
-			"\"peak\":%f," \
-			"\"rms\":%f" \
-		"}," \
-		"\"velocity\": {" \
-			"\"peak\": {" \
-				"\"frequency\":%f," \
-				"\"in_per_sec\":%f," \
-				"\"mm_per_sec\":%f" \
-			"}," \
-			"\"rms\": {" \
-				"\"in_per_sec\":%f," \
-				"\"mm_per_sec\":%f" \
-			"}" \
-		"}" \
-	"}" \
-"}"
-/* clang-format on */
+#ifdef CONFIG_APP_SENSORS_STREAM_RAW
+/* Decoded by pipelines/raw-to-lightdb.yml into the sensor path */
+#define SENSOR_STREAM_PATH "sensor_raw"
+#else
+#define SENSOR_STREAM_PATH "sensor"
+#endif
+#define SUMMARY_STREAM_PATH "summary"
+#define HEALTH_STREAM_PATH  "health"
+#define REGMAP_STREAM_PATH  "regmap"
+
+#define HEALTH_JSON_MAX_LEN                                                                        \
+	(sizeof("{\"loop_count\":4294967295,\"loop_last_us\":4294967295,"                          \
+		"\"loop_avg_us\":4294967295,\"loop_max_us\":4294967295,"                           \
+		"\"jitter_last_us\":4294967295,\"jitter_avg_us\":4294967295,"                      \
+		"\"jitter_max_us\":4294967295,\"missed_deadlines\":4294967295,"                    \
+		"\"units\":[]}") +                                                                 \
+	 CONFIG_APP_BUS_MAX_UNITS *                                                                \
+		      sizeof("{\"id\":247,\"polls\":4294967295,\"missed\":4294967295,"             \
+			     "\"timeout\":4294967295,"                                             \
+			     "\"crc\":4294967295,\"exception\":4294967295,\"other\":4294967295,"   \
+			     "\"latency_min_us\":4294967295,\"latency_avg_us\":4294967295,"        \
+			     "\"latency_max_us\":4294967295,\"latency_hist\":[4294967295,"         \
+			     "4294967295,4294967295,4294967295,4294967295,4294967295,"             \
+			     "4294967295,4294967295]},"))
+
+/* Limits LightDB State writes while the adaptive poll period is ramping */
+#define SENSOR_PERIOD_REPORT_MIN_MS 30000
+
+#ifdef CONFIG_APP_SENSORS_STREAM_FORMAT_JSON
+#define SENSOR_CONTENT_TYPE GOLIOTH_CONTENT_TYPE_JSON
+#define SENSOR_FORMAT_NAME  "JSON"
+#else
+/* Maximum depth of nested CBOR containers:
+ * list -> record -> axis -> velocity -> peak -> summary statistics or decimal fraction
+ */
+#define SENSOR_CBOR_MAX_DEPTH 6
+
+/* Upper bound on the number of elements in any map of the sensor payload:
+ * the seven summary statistics of a metric, or the fields of a register map
+ */
+#define SENSOR_CBOR_MAX_ELEMS                                                                      \
+	COND_CODE_1(CONFIG_APP_REGMAP, (MAX(7, CONFIG_APP_REGMAP_MAX_FIELDS)), (7))
+
+#define SENSOR_CONTENT_TYPE GOLIOTH_CONTENT_TYPE_CBOR
+#define SENSOR_FORMAT_NAME  COND_CODE_1(CONFIG_APP_SENSORS_STREAM_RAW, ("raw CBOR"), ("CBOR"))
+#endif /* CONFIG_APP_SENSORS_STREAM_FORMAT_JSON */
 
 static struct golioth_client *client;
 
-#if DT_NODE_HAS_PROP(ZEPHYR_USER_NODE, rs485_8_click_en_gpios)
-const struct gpio_dt_spec rs485_en = GPIO_DT_SPEC_GET(ZEPHYR_USER_NODE, rs485_8_click_en_gpios);
-#endif
+void app_sensors_init(void)
+{
+	/* The acquisition thread owns the Modbus client */
+	app_acq_init();
+
+	IF_ENABLED(CONFIG_APP_SENSOR_QUEUE, (
+		if (app_queue_init()) {
+			LOG_ERR("Flash queue initialization failed");
+		}
+	));
+}
 
-static int client_iface;
+/* Callback for LightDB Stream */
+static void async_error_handler(struct golioth_client *client, enum golioth_status status,
+				const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
+				void *arg)
+{
+	if (status != GOLIOTH_OK) {
+		LOG_ERR("Async task failed: %d", status);
+		return;
+	}
+}
 
-const static struct modbus_iface_param client_param = {
-	.mode = MODBUS_MODE_RTU,
-	.rx_timeout = 500000,
-	/* clang-format off */
-	.serial = {
-		.baud = 19200,
-		.parity = UART_CFG_PARITY_NONE,
-		.stop_bits_client = UART_CFG_STOP_BITS_1,
+/* Callback for LightDB Stream uploads of sensor data */
+static void sensor_upload_handler(struct golioth_client *client, enum golioth_status status,
+				  const struct golioth_coap_rsp_code *coap_rsp_code,
+				  const char *path, void *arg)
+{
+	if (status != GOLIOTH_OK) {
+		LOG_ERR("Async task failed: %d", status);
+		return;
+	}
+
+	app_boot_mark(APP_BOOT_FIRST_UPLOAD);
+}
+
+/* Deepest path of a metric in a stream record, e.g. x_axis/velocity/peak/frequency */
+#define SENSOR_METRIC_MAX_DEPTH 4
+
+struct sensor_metric {
+	/* Path of the value in a stream record, NULL terminated */
+	const char *path[SENSOR_METRIC_MAX_DEPTH + 1];
+	/* Offset of the fixed-point value in struct qm30vt2_measurement */
+	size_t offset;
+	/* Index in the alias register block */
+	uint8_t reg;
+	/* Decimals of the register, values are handled as fixed-point with these */
+	uint8_t decimals;
+	enum app_deadband deadband;
+	/* Converts the deadband setting to the unit of this metric */
+	float deadband_scale;
+};
+
+/* Deadband setting and its scale for each quantity of QM30VT2_METRICS */
+#define SENSOR_DEADBAND_TEMP_C	APP_DEADBAND_TEMP, 1.0f
+#define SENSOR_DEADBAND_TEMP_F	APP_DEADBAND_TEMP, 1.8f
+#define SENSOR_DEADBAND_ACC_G	APP_DEADBAND_ACC, 1.0f
+#define SENSOR_DEADBAND_VEL_IN	APP_DEADBAND_VEL, 1 / 25.4f
+#define SENSOR_DEADBAND_VEL_MM	APP_DEADBAND_VEL, 1.0f
+#define SENSOR_DEADBAND_FREQ_HZ APP_DEADBAND_FREQ, 1.0f
+#define SENSOR_DEADBAND_RATIO	APP_DEADBAND_SHAPE, 1.0f
+
+#define SENSOR_METRIC_DEADBAND(group, scale) .deadband = group, .deadband_scale = scale
+
+/* Expands SENSOR_DEADBAND_<qty> before it is split into its two arguments */
+#define SENSOR_METRIC_DEADBAND_EXPAND(...) SENSOR_METRIC_DEADBAND(__VA_ARGS__)
+
+#define SENSOR_METRIC(member, NAME, idx, dec, sgn, qty, label, desc, ...)                          \
+	{                                                                                          \
+		.path = {__VA_ARGS__, NULL},                                                       \
+		.offset = offsetof(struct qm30vt2_measurement, member),                            \
+		.reg = (idx),                                                                      \
+		.decimals = (dec),                                                                 \
+		SENSOR_METRIC_DEADBAND_EXPAND(SENSOR_DEADBAND_##qty),                              \
 	},
-	/* clang-format on */
+
+/* Metrics in the order they appear in a stream record, see QM30VT2_METRICS */
+static const struct sensor_metric sensor_metrics[] = {QM30VT2_METRICS(SENSOR_METRIC)};
+
+BUILD_ASSERT(ARRAY_SIZE(sensor_metrics) <= 32, "Metric bitmask must fit in 32 bits");
+
+BUILD_ASSERT(ARRAY_SIZE(sensor_metrics) == QM30VT2_ALIAS_SIZE, "One summary per metric");
+
+#define SENSOR_METRICS_ALL QM30VT2_METRICS_ALL
+
+static inline int32_t *sensor_metric_get(const struct sensor_metric *metric,
+					 const struct qm30vt2_measurement *meas)
+{
+	return (int32_t *)((uint8_t *)meas + metric->offset);
+}
+
+static inline int32_t sensor_metric_fixed(const struct sensor_metric *metric,
+					  const struct qm30vt2_measurement *meas)
+{
+	return *sensor_metric_get(metric, meas);
+}
+
+/* A single record of a sensor stream upload */
+struct sensor_record {
+	const struct qm30vt2_measurement *meas;
+	/* Unix timestamp in milliseconds, 0 if unknown */
+	int64_t ts_ms;
+	uint8_t unit_id;
+	/* Bitmask of sensor_metrics entries to include */
+	uint32_t metrics;
+	/* Window statistics of each metric to send instead of meas, or NULL */
+	const struct app_summary_stats *summary;
+	uint32_t window_s;
+	/* Read back from the flash queue, which does not keep extended registers */
+	bool queued;
+#ifdef CONFIG_APP_REGMAP
+	/* Sample of a unit polled with the register map to send instead of meas, or NULL */
+	const struct app_regmap_sample *regmap;
+	/* Copy of the map of that sample, see app_regmap_get() */
+	const struct app_regmap *map;
+#endif
 };
 
-static int init_modbus_client(void)
+/* Samples in the window of a summary record, all its metrics have the same count */
+static inline uint32_t sensor_summary_count(const struct sensor_record *record)
 {
-	const char iface_name[] = {DEVICE_DT_NAME(MODBUS_NODE)};
+	return record->summary[u32_count_trailing_zeros(record->metrics)].count;
+}
+
+/* Fill in record idx of an upload */
+typedef void (*sensor_record_get_fn)(size_t idx, struct sensor_record *record, void *arg);
 
-	client_iface = modbus_iface_get_by_name(iface_name);
+#ifdef CONFIG_APP_SENSORS_STREAM_FORMAT_JSON
+typedef struct {
+	char *buf;
+	size_t size;
+	size_t len;
+} sensor_writer_t;
 
-	return modbus_init_client(client_iface, client_param);
+static bool json_printf(sensor_writer_t *w, const char *fmt, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintk(&w->buf[w->len], w->size - w->len, fmt, args);
+	va_end(args);
+
+	if ((len < 0) || (len >= w->size - w->len)) {
+		return false;
+	}
+
+	w->len += len;
+
+	return true;
 }
 
-void app_sensors_init(void)
+/* Write a member name, preceded by a comma unless it is the first member */
+static bool json_key(sensor_writer_t *w, const char *key)
 {
-#if DT_NODE_HAS_PROP(ZEPHYR_USER_NODE, rs485_8_click_en_gpios)
-	/* Set the RS-485 transceiver EN signal */
-	if (gpio_pin_configure_dt(&rs485_en, GPIO_OUTPUT_ACTIVE)) {
-		LOG_ERR("RS-485 transceiver enable pin configuration failed");
+	char prev = w->len ? w->buf[w->len - 1] : '\0';
+	bool first = (prev == '{') || (prev == '[') || (prev == '\0');
+
+	return json_printf(w, "%s\"%s\":", first ? "" : ",", key);
+}
+
+static bool sensor_map_start(sensor_writer_t *w, const char *key)
+{
+	return json_key(w, key) && json_printf(w, "{");
+}
+
+static bool sensor_map_end(sensor_writer_t *w)
+{
+	return json_printf(w, "}");
+}
+
+/* Write a fixed-point number without a key */
+static bool json_put_fixed(sensor_writer_t *w, int32_t val, uint8_t decimals)
+{
+	int len = app_fixed_format(&w->buf[w->len], w->size - w->len, val, decimals);
+
+	if ((len < 0) || (len >= w->size - w->len)) {
+		return false;
+	}
+
+	w->len += len;
+
+	return true;
+}
+
+static bool sensor_put_value(sensor_writer_t *w, const char *key, int32_t val, uint8_t decimals)
+{
+	return json_key(w, key) && json_put_fixed(w, val, decimals);
+}
+
+static bool sensor_put_summary(sensor_writer_t *w, const char *key,
+			       const struct app_summary_result *res, uint8_t decimals)
+{
+	const struct {
+		const char *key;
+		float val;
+	} stats[] = {
+		{"min", res->min}, {"max", res->max}, {"mean", res->mean}, {"stddev", res->stddev},
+		{"p50", res->p50}, {"p95", res->p95}, {"p99", res->p99},
+	};
+	bool ok = json_key(w, key) && json_printf(w, "{");
+
+	/* Statistics resolve finer than the register, so keep one more decimal */
+	for (size_t i = 0; ok && (i < ARRAY_SIZE(stats)); i++) {
+		ok = json_key(w, stats[i].key) &&
+		     json_put_fixed(w, app_fixed_from_float(stats[i].val, decimals + 1),
+				    decimals + 1);
+	}
+
+	return ok && json_printf(w, "}");
+}
+#else
+typedef zcbor_state_t sensor_writer_t;
+
+static bool sensor_map_start(zcbor_state_t *zse, const char *key)
+{
+	return zcbor_tstr_encode_ptr(zse, key, strlen(key)) &&
+	       zcbor_map_start_encode(zse, SENSOR_CBOR_MAX_ELEMS);
+}
+
+static bool sensor_map_end(zcbor_state_t *zse)
+{
+	return zcbor_map_end_encode(zse, SENSOR_CBOR_MAX_ELEMS);
+}
+
+#ifdef CONFIG_APP_SENSORS_STREAM_CBOR_DECIMAL
+/* Decimal fraction (RFC 8949, section 3.4.4): [exponent, mantissa] */
+static bool sensor_put_value(zcbor_state_t *zse, const char *key, int32_t val, uint8_t decimals)
+{
+	return zcbor_tstr_encode_ptr(zse, key, strlen(key)) &&
+	       zcbor_tag_put(zse, ZCBOR_TAG_DECFRAC_ARR) && zcbor_list_start_encode(zse, 2) &&
+	       zcbor_int32_put(zse, -(int32_t)decimals) && zcbor_int32_put(zse, val) &&
+	       zcbor_list_end_encode(zse, 2);
+}
+#else
+static bool sensor_put_value(zcbor_state_t *zse, const char *key, int32_t val, uint8_t decimals)
+{
+	return zcbor_tstr_encode_ptr(zse, key, strlen(key)) &&
+	       zcbor_float64_put(zse, (double)val / app_fixed_pow10(decimals));
+}
+#endif /* CONFIG_APP_SENSORS_STREAM_CBOR_DECIMAL */
+
+static bool sensor_put_summary(zcbor_state_t *zse, const char *key,
+			       const struct app_summary_result *res, uint8_t decimals)
+{
+	/* Single precision is all the statistics carry */
+	return zcbor_tstr_encode_ptr(zse, key, strlen(key)) &&
+	       zcbor_map_start_encode(zse, SENSOR_CBOR_MAX_ELEMS) &&
+	       zcbor_tstr_put_lit(zse, "min") && zcbor_float32_put(zse, res->min) &&
+	       zcbor_tstr_put_lit(zse, "max") && zcbor_float32_put(zse, res->max) &&
+	       zcbor_tstr_put_lit(zse, "mean") && zcbor_float32_put(zse, res->mean) &&
+	       zcbor_tstr_put_lit(zse, "stddev") && zcbor_float32_put(zse, res->stddev) &&
+	       zcbor_tstr_put_lit(zse, "p50") && zcbor_float32_put(zse, res->p50) &&
+	       zcbor_tstr_put_lit(zse, "p95") && zcbor_float32_put(zse, res->p95) &&
+	       zcbor_tstr_put_lit(zse, "p99") && zcbor_float32_put(zse, res->p99) &&
+	       zcbor_map_end_encode(zse, SENSOR_CBOR_MAX_ELEMS);
+}
+#endif /* CONFIG_APP_SENSORS_STREAM_FORMAT_JSON */
+
+/* Write the selected metrics of a record, opening and closing nested maps as their paths
+ * change. Each metric is either its value or, for summary records, its window statistics.
+ */
+static bool sensor_metrics_encode(sensor_writer_t *w, const struct sensor_record *record)
+{
+	const char *const *open_path = NULL;
+	size_t depth = 0;
+	bool ok = true;
+
+	for (size_t i = 0; ok && (i < ARRAY_SIZE(sensor_metrics)); i++) {
+		const struct sensor_metric *metric = &sensor_metrics[i];
+		size_t leaf = 0;
+		size_t common = 0;
+
+		if (!(record->metrics & BIT(i))) {
+			continue;
+		}
+
+		while (metric->path[leaf + 1]) {
+			leaf++;
+		}
+
+		while ((common < depth) && (common < leaf) &&
+		       (strcmp(open_path[common], metric->path[common]) == 0)) {
+			common++;
+		}
+
+		for (; ok && (depth > common); depth--) {
+			ok = sensor_map_end(w);
+		}
+		for (; ok && (depth < leaf); depth++) {
+			ok = sensor_map_start(w, metric->path[depth]);
+		}
+
+		if (ok && record->summary) {
+			struct app_summary_result res;
+
+			app_summary_get(&record->summary[i], &res);
+			ok = sensor_put_summary(w, metric->path[leaf], &res, metric->decimals);
+		} else if (ok) {
+			ok = sensor_put_value(w, metric->path[leaf],
+					      sensor_metric_fixed(metric, record->meas),
+					      metric->decimals);
+		}
+
+		open_path = metric->path;
+	}
+
+	for (; ok && (depth > 0); depth--) {
+		ok = sensor_map_end(w);
+	}
+
+	return ok;
+}
+
+#ifdef CONFIG_APP_REGMAP
+/* Write the values of a register map sample in a map named after the register map */
+static bool sensor_regmap_encode(sensor_writer_t *w, const struct sensor_record *record)
+{
+	const struct app_regmap_field *fields = record->map->fields;
+	bool ok = sensor_map_start(w, record->map->name);
+
+	for (size_t i = 0; ok && (i < record->regmap->count); i++) {
+		ok = sensor_put_value(w, fields[i].name, record->regmap->val[i],
+				      fields[i].decimals);
+	}
+
+	return ok && sensor_map_end(w);
+}
+#endif /* CONFIG_APP_REGMAP */
+
+#ifdef CONFIG_APP_SENSORS_STREAM_FORMAT_JSON
+/* Raw values of the extended registers, see CONFIG_APP_QM30VT2_EXT */
+static bool sensor_ext_encode(sensor_writer_t *w, const struct qm30vt2_measurement *meas)
+{
+	bool ok = true;
+
+#ifdef CONFIG_APP_QM30VT2_EXT
+	for (size_t i = 0; ok && (i < qm30vt2_ext_count()); i++) {
+		ok = json_printf(w, "%s%u", (i == 0) ? ",\"ext\":[" : ",", meas->ext_reg[i]);
+	}
+	if (ok && qm30vt2_ext_count()) {
+		ok = json_printf(w, "]");
 	}
 #endif
 
-	if (init_modbus_client()) {
-		LOG_ERR("Modbus RTU client initialization failed");
+	return ok;
+}
+
+static bool sensor_record_encode(sensor_writer_t *w, const struct sensor_record *record)
+{
+	bool ok;
+
+	ok = json_printf(w, "{\"unit\":%u", record->unit_id);
+
+	if (ok && record->ts_ms) {
+		ok = json_printf(w, ",\"ts\":%lld", (long long)record->ts_ms);
+	}
+
+	if (ok && record->summary) {
+		ok = json_printf(w, ",\"window_s\":%u,\"count\":%u", record->window_s,
+				 sensor_summary_count(record));
 	}
+
+#ifdef CONFIG_APP_REGMAP
+	if (record->regmap) {
+		return ok && sensor_regmap_encode(w, record) && json_printf(w, "}");
+	}
+#endif
+
+	if (ok && !record->summary && !record->queued) {
+		ok = sensor_ext_encode(w, record->meas);
+	}
+
+	return ok && sensor_metrics_encode(w, record) && json_printf(w, "}");
 }
 
-/* Callback for LightDB Stream */
-static void async_error_handler(struct golioth_client *client, enum golioth_status status,
-				const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
-				void *arg)
+static int sensor_payload_encode(sensor_record_get_fn get, void *arg, size_t count, uint8_t *buf,
+				 size_t buf_len, size_t *payload_len)
 {
-	if (status != GOLIOTH_OK) {
-		LOG_ERR("Async task failed: %d", status);
+	sensor_writer_t w = {
+		.buf = (char *)buf,
+		.size = buf_len,
+	};
+	struct sensor_record record;
+	bool ok;
+
+	ok = json_printf(&w, "[");
+
+	for (size_t i = 0; ok && (i < count); i++) {
+		/* Fields a getter does not set, such as summary, stay cleared */
+		record = (struct sensor_record){0};
+		get(i, &record, arg);
+		ok = ((i == 0) || json_printf(&w, ",")) && sensor_record_encode(&w, &record);
+	}
+
+	ok = ok && json_printf(&w, "]");
+	if (!ok) {
+		return -ENOMEM;
+	}
+
+	*payload_len = w.len;
+
+	return 0;
+}
+#else
+#ifdef CONFIG_APP_SENSORS_STREAM_RAW
+/* Write the alias register block of a measurement as read from the sensor. The
+ * fixed-point value of a metric is its register value, so the block is rebuilt
+ * exactly; temperatures wrap back to their two's complement form.
+ */
+static bool sensor_regs_encode(zcbor_state_t *zse, const struct qm30vt2_measurement *meas)
+{
+	uint16_t regs[QM30VT2_ALIAS_SIZE];
+	bool ok;
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensor_metrics); i++) {
+		regs[sensor_metrics[i].reg] = (uint16_t)sensor_metric_fixed(&sensor_metrics[i], meas);
+	}
+
+	ok = zcbor_tstr_put_lit(zse, "regs") && zcbor_list_start_encode(zse, ARRAY_SIZE(regs));
+
+	for (size_t i = 0; ok && (i < ARRAY_SIZE(regs)); i++) {
+		ok = zcbor_uint32_put(zse, regs[i]);
+	}
+
+	return ok && zcbor_list_end_encode(zse, ARRAY_SIZE(regs));
+}
+#endif /* CONFIG_APP_SENSORS_STREAM_RAW */
+
+/* Raw values of the extended registers, see CONFIG_APP_QM30VT2_EXT */
+static bool sensor_ext_encode(zcbor_state_t *zse, const struct qm30vt2_measurement *meas)
+{
+	bool ok = true;
+
+#ifdef CONFIG_APP_QM30VT2_EXT
+	if (qm30vt2_ext_count()) {
+		ok = zcbor_tstr_put_lit(zse, "ext") &&
+		     zcbor_list_start_encode(zse, CONFIG_APP_QM30VT2_EXT_REGS_MAX);
+		for (size_t i = 0; ok && (i < qm30vt2_ext_count()); i++) {
+			ok = zcbor_uint32_put(zse, meas->ext_reg[i]);
+		}
+		ok = ok && zcbor_list_end_encode(zse, CONFIG_APP_QM30VT2_EXT_REGS_MAX);
+	}
+#endif
+
+	return ok;
+}
+
+static bool sensor_record_encode(zcbor_state_t *zse, const struct sensor_record *record)
+{
+	bool ok;
+
+	ok = zcbor_map_start_encode(zse, SENSOR_CBOR_MAX_ELEMS) && zcbor_tstr_put_lit(zse, "unit") &&
+	     zcbor_uint32_put(zse, record->unit_id);
+
+	if (ok && record->ts_ms) {
+		ok = zcbor_tstr_put_lit(zse, "ts") && zcbor_int64_put(zse, record->ts_ms);
+	}
+
+	if (ok && record->summary) {
+		ok = zcbor_tstr_put_lit(zse, "window_s") && zcbor_uint32_put(zse, record->window_s) &&
+		     zcbor_tstr_put_lit(zse, "count") &&
+		     zcbor_uint32_put(zse, sensor_summary_count(record));
+	}
+
+#ifdef CONFIG_APP_REGMAP
+	if (record->regmap) {
+		return ok && sensor_regmap_encode(zse, record) &&
+		       zcbor_map_end_encode(zse, SENSOR_CBOR_MAX_ELEMS);
+	}
+#endif
+
+	if (ok && !record->summary && !record->queued) {
+		ok = sensor_ext_encode(zse, record->meas);
+	}
+
+#ifdef CONFIG_APP_SENSORS_STREAM_RAW
+	/* Summaries have no registers and keep their named fields */
+	if (!record->summary) {
+		/* Registers of other metrics are not expanded by the decoder */
+		if (ok && (record->metrics != SENSOR_METRICS_ALL)) {
+			ok = zcbor_tstr_put_lit(zse, "metrics") &&
+			     zcbor_uint32_put(zse, record->metrics);
+		}
+
+		return ok && sensor_regs_encode(zse, record->meas) &&
+		       zcbor_map_end_encode(zse, SENSOR_CBOR_MAX_ELEMS);
+	}
+#endif
+
+	return ok && sensor_metrics_encode(zse, record) &&
+	       zcbor_map_end_encode(zse, SENSOR_CBOR_MAX_ELEMS);
+}
+
+static int sensor_payload_encode(sensor_record_get_fn get, void *arg, size_t count, uint8_t *buf,
+				 size_t buf_len, size_t *payload_len)
+{
+	struct sensor_record record;
+	bool ok;
+
+	ZCBOR_STATE_E(zse, SENSOR_CBOR_MAX_DEPTH, buf, buf_len, 1);
+
+	ok = zcbor_list_start_encode(zse, count);
+
+	for (size_t i = 0; ok && (i < count); i++) {
+		/* Fields a getter does not set, such as summary, stay cleared */
+		record = (struct sensor_record){0};
+		get(i, &record, arg);
+		ok = sensor_record_encode(zse, &record);
+	}
+
+	ok = ok && zcbor_list_end_encode(zse, count);
+	if (!ok) {
+		return -ENOMEM;
+	}
+
+	*payload_len = zse->payload - buf;
+
+	return 0;
+}
+#endif /* CONFIG_APP_SENSORS_STREAM_FORMAT_JSON */
+
+/* Encode up to count records in buf and send them to path as a single LightDB Stream
+ * array. Fewer records are sent if they do not all fit; the number sent is returned and
+ * also passed as the argument of the completion callback cb.
+ */
+static int sensor_upload(const char *path, sensor_record_get_fn get, void *arg, size_t count,
+			 uint8_t *buf, size_t buf_len, golioth_set_cb_fn cb)
+{
+	size_t payload_len;
+	uint32_t encode_start;
+	int err;
+
+	encode_start = k_cycle_get_32();
+
+	while (true) {
+		err = sensor_payload_encode(get, arg, count, buf, buf_len, &payload_len);
+		if ((err != -ENOMEM) || (count == 1)) {
+			break;
+		}
+		count--;
+	}
+
+	if (err) {
+		LOG_ERR("Failed to encode sensor data: %d", err);
+		return err;
+	}
+
+	LOG_DBG("Encoded %zu samples in %zu byte %s payload in %u us", count, payload_len,
+		SENSOR_FORMAT_NAME, k_cyc_to_us_floor32(k_cycle_get_32() - encode_start));
+
+	err = golioth_stream_set_async(client,
+				       path,
+				       SENSOR_CONTENT_TYPE,
+				       buf,
+				       payload_len,
+				       cb,
+				       NULL);
+	if (err) {
+		LOG_ERR("Failed to send sensor data to Golioth: %d", err);
+		return err;
+	}
+
+	return count;
+}
+
+static void batch_record_get(size_t idx, struct sensor_record *record, void *arg)
+{
+	const struct app_batch_sample *sample = app_batch_get(idx);
+	const int64_t *ts_offset_ms = arg;
+
+	record->meas = &sample->meas;
+	record->ts_ms = ts_offset_ms ? sample->uptime_ms + *ts_offset_ms : 0;
+	record->unit_id = sample->unit_id;
+	record->metrics = sample->metrics;
+}
+
+/* Payload buffer for uploads from the main loop */
+static uint8_t payload_buf[CONFIG_APP_SENSORS_PAYLOAD_BUF_SIZE];
+
+/* Shortest and longest pause of batch uploads after one fails */
+#define BATCH_RETRY_MIN_MS 1000
+#define BATCH_RETRY_MAX_MS 60000
+
+/* Buffered samples stay in RAM until Golioth acknowledges their upload. Only one batch
+ * upload is in flight; its result is handed back to the main loop, which drops the
+ * samples on success and backs off on failure.
+ */
+static atomic_t batch_inflight;
+static atomic_t batch_result;
+/* Sequence number following the last sample of the batch in flight */
+static uint32_t batch_end_seq;
+static uint32_t batch_backoff_ms;
+static int64_t batch_retry_ms;
+
+/* Callback for LightDB Stream uploads of buffered samples */
+static void batch_upload_handler(struct golioth_client *client, enum golioth_status status,
+				 const struct golioth_coap_rsp_code *coap_rsp_code,
+				 const char *path, void *arg)
+{
+	if (status == GOLIOTH_OK) {
+		atomic_set(&batch_result, 1);
+		app_boot_mark(APP_BOOT_FIRST_UPLOAD);
+	} else {
+		LOG_WRN("Failed to upload buffered samples: %d", status);
+		atomic_set(&batch_result, -1);
+	}
+
+	atomic_clear(&batch_inflight);
+}
+
+/* Settle the result of the last batch upload. Returns false while an upload is in
+ * flight or after a failure until the backoff expires.
+ */
+static bool sensor_batch_ready(void)
+{
+	atomic_val_t result;
+
+	if (atomic_get(&batch_inflight)) {
+		return false;
+	}
+
+	result = atomic_set(&batch_result, 0);
+	if (result > 0) {
+		app_batch_drop_until(batch_end_seq);
+		batch_backoff_ms = 0;
+		batch_retry_ms = 0;
+	} else if (result < 0) {
+		batch_backoff_ms = CLAMP(2 * batch_backoff_ms, BATCH_RETRY_MIN_MS,
+					 BATCH_RETRY_MAX_MS);
+		batch_retry_ms = k_uptime_get() + batch_backoff_ms;
+		LOG_WRN("Retrying buffered samples in %u ms", batch_backoff_ms);
+	}
+
+	return k_uptime_get() >= batch_retry_ms;
+}
+
+/* Upload the oldest buffered samples as a single LightDB Stream array */
+static int sensor_batch_flush(void)
+{
+	static bool ts_warned;
+	int64_t ts_offset_ms;
+	size_t count;
+	bool has_ts;
+	int sent;
+
+	if (!sensor_batch_ready()) {
+		return -EBUSY;
+	}
+
+	count = MIN(app_batch_count(), get_batch_flush_count());
+	if (count == 0) {
+		return 0;
+	}
+
+	has_ts = (app_time_unix_offset_ms(&ts_offset_ms) == 0);
+	if (!has_ts && !ts_warned) {
+		LOG_WRN("Wall clock not available, samples will be stamped on arrival");
+		ts_warned = true;
+	}
+
+	atomic_set(&batch_inflight, 1);
+
+	sent = sensor_upload(SENSOR_STREAM_PATH, batch_record_get, has_ts ? &ts_offset_ms : NULL,
+			     count, payload_buf, sizeof(payload_buf), batch_upload_handler);
+	if (sent < 0) {
+		atomic_clear(&batch_inflight);
+		return sent;
+	}
+
+	batch_end_seq = app_batch_seq() + sent;
+
+	return 0;
+}
+
+/* Upload of a single record prepared by the caller */
+static void single_record_get(size_t idx, struct sensor_record *record, void *arg)
+{
+	*record = *(const struct sensor_record *)arg;
+}
+
+static void sensor_summary_add(struct app_bus_unit *unit, int64_t now, uint32_t mask)
+{
+	if (unit->summary_start_ms == 0) {
+		for (size_t i = 0; i < ARRAY_SIZE(unit->summary); i++) {
+			app_summary_reset(&unit->summary[i]);
+		}
+		unit->summary_start_ms = now;
+		unit->summary_sent = 0;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensor_metrics); i++) {
+		if (!(mask & BIT(i))) {
+			continue;
+		}
+
+		app_summary_add(&unit->summary[i], qm30vt2_metric_float(&unit->meas, i));
+	}
+}
+
+/* Window statistics of a unit copied with the unit locked, uploaded once it is unlocked */
+static struct app_summary_stats summary_snap[QM30VT2_ALIAS_SIZE];
+
+/* Upload the window statistics of the metrics of a unit in a mask as one record per
+ * top-level group (temperature, x_axis, z_axis) so each fits in a single payload.
+ * Groups already in sent are skipped, and those sent now are added to it, so a retry
+ * after a failure does not send them twice.
+ */
+static int sensor_summary_upload(uint8_t unit_id, const struct app_summary_stats *summary,
+				 int64_t start_ms, int64_t now, uint32_t mask, uint32_t *sent_mask)
+{
+	struct sensor_record record = {
+		.unit_id = unit_id,
+		.summary = summary,
+		.window_s = (now - start_ms) / MSEC_PER_SEC,
+	};
+	int64_t ts_offset_ms;
+	size_t i = 0;
+	int sent;
+
+	if (app_time_unix_offset_ms(&ts_offset_ms) == 0) {
+		record.ts_ms = now + ts_offset_ms;
+	}
+
+	while (i < ARRAY_SIZE(sensor_metrics)) {
+		const char *group = sensor_metrics[i].path[0];
+
+		record.metrics = 0;
+		for (; (i < ARRAY_SIZE(sensor_metrics)) &&
+		       (strcmp(sensor_metrics[i].path[0], group) == 0);
+		     i++) {
+			record.metrics |= BIT(i);
+		}
+
+		record.metrics &= mask & ~*sent_mask;
+		if (!record.metrics) {
+			continue;
+		}
+
+		sent = sensor_upload(SUMMARY_STREAM_PATH, single_record_get, &record, 1,
+				     payload_buf, sizeof(payload_buf), sensor_upload_handler);
+		if (sent < 0) {
+			return sent;
+		}
+
+		*sent_mask |= record.metrics;
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_APP_SENSOR_QUEUE
+static struct app_queue_record drain_records[CONFIG_APP_QUEUE_DRAIN_BATCH];
+static struct qm30vt2_measurement drain_meas[CONFIG_APP_QUEUE_DRAIN_BATCH];
+
+static void queue_record_get(size_t idx, struct sensor_record *record, void *arg)
+{
+	record->meas = &drain_meas[idx];
+	record->ts_ms = drain_records[idx].ts_ms;
+	record->unit_id = drain_records[idx].unit_id;
+	record->metrics = drain_records[idx].metrics;
+	record->queued = true;
+}
+
+/* Longest pause of the drain after uploads of queued records fail */
+#define QUEUE_DRAIN_BACKOFF_MAX_MS 60000
+
+/* Queued records stay in flash until Golioth acknowledges their upload. Only one drain
+ * upload is in flight; its result is handed back to the drain work, which pops the
+ * records on success and backs off on failure.
+ */
+static atomic_t drain_inflight;
+static atomic_t drain_result;
+/* Sequence number of the last record of the upload in flight */
+static uint32_t drain_last_seq;
+static uint32_t drain_backoff_ms;
+
+static void queue_drain_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(queue_drain_work, queue_drain_work_handler);
+
+/* Callback for LightDB Stream uploads of queued records */
+static void queue_drain_upload_handler(struct golioth_client *client,
+				       enum golioth_status status,
+				       const struct golioth_coap_rsp_code *coap_rsp_code,
+				       const char *path, void *arg)
+{
+	if (status == GOLIOTH_OK) {
+		atomic_set(&drain_result, 1);
+		app_boot_mark(APP_BOOT_FIRST_UPLOAD);
+	} else {
+		LOG_WRN("Failed to upload queued samples: %d", status);
+		atomic_set(&drain_result, -1);
+	}
+
+	atomic_clear(&drain_inflight);
+	k_work_reschedule(&queue_drain_work, K_NO_WAIT);
+}
+
+/* Send queued records at a bounded rate so live data is not held up after reconnecting */
+static void queue_drain_work_handler(struct k_work *work)
+{
+	static uint8_t drain_buf[CONFIG_APP_SENSORS_PAYLOAD_BUF_SIZE];
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	atomic_val_t result;
+	size_t count;
+	int sent;
+	int err;
+
+	result = atomic_set(&drain_result, 0);
+	if (result > 0) {
+		app_queue_pop(drain_last_seq);
+		drain_backoff_ms = 0;
+		k_work_reschedule(dwork, K_MSEC(CONFIG_APP_QUEUE_DRAIN_INTERVAL_MS));
 		return;
 	}
+
+	if (result < 0) {
+		app_queue_drain_done();
+		drain_backoff_ms = CLAMP(2 * drain_backoff_ms, CONFIG_APP_QUEUE_DRAIN_INTERVAL_MS,
+					 QUEUE_DRAIN_BACKOFF_MAX_MS);
+		LOG_WRN("Retrying queued samples in %u ms", drain_backoff_ms);
+		k_work_reschedule(dwork, K_MSEC(drain_backoff_ms));
+		return;
+	}
+
+	if (atomic_get(&drain_inflight)) {
+		return;
+	}
+
+	if (!golioth_client_is_connected(client)) {
+		app_queue_drain_done();
+		return;
+	}
+
+	err = app_queue_peek(drain_records, ARRAY_SIZE(drain_records), &count);
+	if (err || count == 0) {
+		app_queue_drain_done();
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		qm30vt2_decode(drain_records[i].holding_reg, &drain_meas[i],
+			       drain_records[i].metrics);
+	}
+
+	atomic_set(&drain_inflight, 1);
+
+	sent = sensor_upload(SENSOR_STREAM_PATH, queue_record_get, NULL, count, drain_buf,
+			     sizeof(drain_buf), queue_drain_upload_handler);
+	if (sent < 0) {
+		atomic_clear(&drain_inflight);
+		k_work_reschedule(dwork, K_MSEC(CONFIG_APP_QUEUE_DRAIN_INTERVAL_MS));
+		return;
+	}
+
+	drain_last_seq = drain_records[sent - 1].seq;
+}
+
+static int sensor_queue_append(const uint16_t *holding_reg, uint8_t unit_id, uint32_t metrics,
+			       int64_t uptime_ms)
+{
+	struct app_queue_record record = {
+		.metrics = metrics,
+		.unit_id = unit_id,
+	};
+	int64_t ts_offset_ms;
+	int err;
+
+	if (app_time_unix_offset_ms(&ts_offset_ms) == 0) {
+		record.ts_ms = uptime_ms + ts_offset_ms;
+	}
+
+	memcpy(record.holding_reg, holding_reg, sizeof(record.holding_reg));
+
+	err = app_queue_append(&record);
+	if (!err) {
+		APP_LOG_WRN_RL("Device is not connected to Golioth, %zu samples queued in flash",
+			       app_queue_pending());
+	}
+
+	return err;
+}
+#else
+static int sensor_queue_append(const uint16_t *holding_reg, uint8_t unit_id, uint32_t metrics,
+			       int64_t uptime_ms)
+{
+	return -ENOTSUP;
+}
+#endif /* CONFIG_APP_SENSOR_QUEUE */
+
+void app_sensors_client_connected(void)
+{
+	IF_ENABLED(CONFIG_APP_SENSOR_QUEUE, (
+		if (app_queue_pending()) {
+			k_work_schedule(&queue_drain_work, K_NO_WAIT);
+		}
+	));
+}
+
+/* Report-by-exception counters */
+static struct {
+	uint32_t records_sent;
+	uint32_t records_suppressed;
+	uint32_t metrics_sent;
+	uint32_t metrics_suppressed;
+} rbe_stats;
+
+/* A metric is reported when it has moved from its last reported value by more than
+ * the larger of the absolute deadband of its group and RBE_DEADBAND_PCT percent.
+ * Values are compared as fixed-point, in register units.
+ */
+static bool sensor_metric_changed(const struct sensor_metric *metric, int32_t val, int32_t ref)
+{
+	int64_t band = app_fixed_from_float(get_rbe_deadband(metric->deadband) *
+						    metric->deadband_scale,
+					    metric->decimals);
+	int64_t pct_band = (int64_t)ABS(ref) * get_rbe_deadband_pct() / 100;
+
+	return ABS((int64_t)val - ref) > MAX(band, pct_band);
+}
+
+/* Select the metrics in a mask of the latest measurement of a unit that should be
+ * reported; every metric in the mask is selected when full is set.
+ */
+static uint32_t sensor_rbe_select(struct app_bus_unit *unit, bool full, uint32_t mask)
+{
+	int64_t heartbeat_ms = (int64_t)get_rbe_heartbeat_s() * MSEC_PER_SEC;
+	int64_t now = k_uptime_get();
+	uint32_t metrics = 0;
+
+	if (full || (heartbeat_ms == 0) || (unit->reported_full_ms == 0) ||
+	    (now - unit->reported_full_ms >= heartbeat_ms)) {
+		/* Forced, report-by-exception off, first sample or heartbeat due */
+		unit->reported = unit->meas;
+		unit->reported_full_ms = now;
+		metrics = mask;
+	} else {
+		for (size_t i = 0; i < ARRAY_SIZE(sensor_metrics); i++) {
+			const struct sensor_metric *metric = &sensor_metrics[i];
+			int32_t *val = sensor_metric_get(metric, &unit->meas);
+			int32_t *ref = sensor_metric_get(metric, &unit->reported);
+
+			if ((mask & BIT(i)) &&
+			    sensor_metric_changed(metric, *val, *ref)) {
+				*ref = *val;
+				metrics |= BIT(i);
+			}
+		}
+	}
+
+	if (metrics) {
+		rbe_stats.records_sent++;
+	} else {
+		rbe_stats.records_suppressed++;
+	}
+	rbe_stats.metrics_sent += popcount(metrics);
+	rbe_stats.metrics_suppressed += popcount(mask) - popcount(metrics);
+
+	return metrics;
+}
+
+/* Effective poll periods changed since they were last written to LightDB State */
+static bool period_changed;
+
+/* The upload path needs every sample, so it receives a copy of each message */
+ZBUS_MSG_SUBSCRIBER_DEFINE(sensors_sub);
+ZBUS_CHAN_ADD_OBS(app_acq_meas_chan, sensors_sub, 1);
+#ifdef CONFIG_APP_REGMAP
+ZBUS_CHAN_ADD_OBS(app_acq_regmap_chan, sensors_sub, 1);
+#endif
+
+/* Message of any channel sensors_sub observes */
+static union {
+	struct app_acq_meas meas;
+#ifdef CONFIG_APP_REGMAP
+	struct app_regmap_sample regmap;
+#endif
+} sensors_msg;
+
+static void sensor_log_cb(const struct zbus_channel *chan)
+{
+	const struct app_acq_meas *msg = zbus_chan_const_msg(chan);
+
+	qm30vt2_log_measurements(msg->unit_id, &msg->meas, msg->metrics);
+}
+
+ZBUS_LISTENER_DEFINE(sensors_log_lis, sensor_log_cb);
+ZBUS_CHAN_ADD_OBS(app_acq_meas_chan, sensors_log_lis, 2);
+
+/* Uploads decided with a unit locked and made once it is unlocked */
+struct sensor_deferred {
+	struct app_alarm_events alarms;
+	/* Window of the statistics in summary_snap to send, start 0 if none */
+	int64_t summary_start_ms;
+	int64_t summary_end_ms;
+	uint32_t summary_sent;
+};
+
+/* Decode, evaluate and queue for upload the measurement of one unit, which is locked
+ * against reconfiguration. Returns true if the sample should also be stored in flash.
+ * urgent is set when an alarm level changed and buffered samples should be sent
+ * without waiting.
+ */
+static bool sensor_process_unit(struct app_bus_unit *unit, const struct app_acq_meas *msg,
+				uint32_t *metrics, bool *urgent, struct sensor_deferred *deferred)
+{
+	bool alarm;
+
+	alarm = app_alarm_evaluate(&unit->alarm, unit->cfg.id, &unit->meas);
+	if (alarm && golioth_client_is_connected(client)) {
+		app_alarm_take(&unit->alarm, unit->cfg.id, &deferred->alarms);
+		*urgent = true;
+	}
+
+	if ((unit->cfg.period_s == 0) && app_adaptive_enabled()) {
+		uint32_t period_s = unit->adaptive.period_s;
+
+		if (app_adaptive_update(&unit->adaptive, &unit->alarm, &unit->meas) != period_s) {
+			period_changed = true;
+		}
+	}
+
+	if (get_summary_window_s()) {
+		int64_t now = k_uptime_get();
+
+		sensor_summary_add(unit, now, msg->metrics);
+
+		/* A window that ends offline is extended until it can be sent */
+		if ((now - unit->summary_start_ms >= get_summary_window_s() * MSEC_PER_SEC) &&
+		    golioth_client_is_connected(client)) {
+			memcpy(summary_snap, unit->summary, sizeof(summary_snap));
+			deferred->summary_start_ms = unit->summary_start_ms;
+			deferred->summary_end_ms = now;
+			deferred->summary_sent = unit->summary_sent;
+		}
+
+		/* Only samples that changed an alarm level are sent raw, in full */
+		*metrics = alarm ? sensor_rbe_select(unit, true, msg->metrics) : 0;
+		if (!*metrics) {
+			return false;
+		}
+	} else {
+		unit->summary_start_ms = 0;
+
+		/* Send the sample that changed an alarm level in full */
+		*metrics = sensor_rbe_select(unit, alarm, msg->metrics);
+		if (!*metrics) {
+			LOG_DBG("No change beyond deadbands on unit %u, sample suppressed",
+				unit->cfg.id);
+			return false;
+		}
+	}
+
+	if (golioth_client_is_connected(client)) {
+		app_batch_push(&unit->meas, unit->cfg.id, *metrics, msg->uptime_ms);
+		return false;
+	}
+
+	return true;
+}
+
+/* Hand one sample published by the acquisition thread to the upload path */
+static void sensor_process_meas(const struct app_acq_meas *msg, bool *urgent)
+{
+	struct sensor_deferred deferred = {0};
+	struct app_bus_unit *unit;
+	uint32_t metrics = 0;
+	bool store;
+
+	/* The unit may have been removed by a new configuration since it was polled */
+	unit = app_bus_unit_lock(msg->unit_id);
+	if (!unit) {
+		return;
+	}
+
+	unit->meas = msg->meas;
+	store = sensor_process_unit(unit, msg, &metrics, urgent, &deferred);
+
+	app_bus_unit_unlock();
+
+	/* Uploads and flash writes are kept out of the lock, which the acquisition thread
+	 * also takes
+	 */
+	if (deferred.alarms.count) {
+		(void)app_alarm_report(client, &deferred.alarms, &msg->meas);
+	}
+
+	if (deferred.summary_start_ms) {
+		int err = sensor_summary_upload(msg->unit_id, summary_snap,
+						deferred.summary_start_ms, deferred.summary_end_ms,
+						msg->metrics, &deferred.summary_sent);
+
+		unit = app_bus_unit_lock(msg->unit_id);
+		if (unit) {
+			/* Unless a new configuration restarted the window meanwhile */
+			if (unit->summary_start_ms == deferred.summary_start_ms) {
+				unit->summary_sent = deferred.summary_sent;
+				if (!err) {
+					unit->summary_start_ms = 0;
+				}
+			}
+			app_bus_unit_unlock();
+		}
+	}
+
+	if (store && sensor_queue_append(msg->holding_reg, msg->unit_id, metrics, msg->uptime_ms)) {
+		/* Persist samples taken while offline, falling back to the RAM buffer */
+		app_batch_push(&msg->meas, msg->unit_id, metrics, msg->uptime_ms);
+		APP_LOG_WRN_RL("Device is not connected to Golioth, %zu samples buffered",
+			       app_batch_count());
+	}
+}
+
+#ifdef CONFIG_APP_REGMAP
+/* Map of the last register map sample that was sent; only used by the main loop */
+static struct app_regmap regmap_copy;
+
+/* Send a register map sample right away; they are not batched, summarized or queued */
+static void sensor_process_regmap(const struct app_regmap_sample *sample)
+{
+	struct sensor_record record = {
+		.unit_id = sample->unit_id,
+		.regmap = sample,
+	};
+	int64_t ts_offset_ms;
+
+	if (!golioth_client_is_connected(client)) {
+		APP_LOG_WRN_RL("Device is not connected to Golioth, sample of unit %u dropped",
+			       sample->unit_id);
+		return;
+	}
+
+	/* Names and decimals must be those of the map the sample was decoded with. They are
+	 * copied, only when a new map was applied, so the upload runs without the map locked.
+	 */
+	if ((regmap_copy.field_count == 0) || (regmap_copy.generation != sample->generation)) {
+		if (app_regmap_get(sample->generation, &regmap_copy)) {
+			regmap_copy.field_count = 0;
+			LOG_DBG("Register map changed since unit %u was polled, sample dropped",
+				sample->unit_id);
+			return;
+		}
+	}
+	record.map = &regmap_copy;
+
+	if (app_time_unix_offset_ms(&ts_offset_ms) == 0) {
+		record.ts_ms = sample->uptime_ms + ts_offset_ms;
+	}
+
+	(void)sensor_upload(REGMAP_STREAM_PATH, single_record_get, &record, 1, payload_buf,
+			    sizeof(payload_buf), sensor_upload_handler);
+}
+#endif /* CONFIG_APP_REGMAP */
+
+/* Hand the message sensors_sub received from chan to the upload path */
+static void sensor_process_msg(const struct zbus_channel *chan, bool *urgent)
+{
+#ifdef CONFIG_APP_REGMAP
+	if (chan == &app_acq_regmap_chan) {
+		sensor_process_regmap(&sensors_msg.regmap);
+		return;
+	}
+#endif
+
+	sensor_process_meas(&sensors_msg.meas, urgent);
+}
+
+/* Log and report the boot trace once the first sensor upload has been accepted */
+static void sensor_startup_report(void)
+{
+	static bool reported;
+
+	if (reported || !app_boot_phase_ms(APP_BOOT_FIRST_UPLOAD) ||
+	    !golioth_client_is_connected(client)) {
+		return;
+	}
+
+	app_boot_log();
+
+	if (app_state_report_startup() == 0) {
+		reported = true;
+	}
+}
+
+/* Report effective poll periods, at most every SENSOR_PERIOD_REPORT_MIN_MS */
+static void sensor_period_report(void)
+{
+	static int64_t last_report_ms;
+	int64_t now = k_uptime_get();
+
+	if (!period_changed || !golioth_client_is_connected(client) ||
+	    ((last_report_ms != 0) && (now - last_report_ms < SENSOR_PERIOD_REPORT_MIN_MS))) {
+		return;
+	}
+
+	if (app_state_update_actual() == 0) {
+		period_changed = false;
+		last_report_ms = now;
+	}
+}
+
+#ifdef CONFIG_APP_BUS_HEALTH_STREAM
+static void sensor_health_stream(void)
+{
+	static char hbuf[HEALTH_JSON_MAX_LEN + 2];
+	int len;
+	int err;
+
+	/* Sent as an array like every other stream payload */
+	hbuf[0] = '[';
+	len = app_bus_health_to_json(&hbuf[1], sizeof(hbuf) - 2);
+	if (len < 0) {
+		LOG_ERR("Failed to encode bus health: %d", len);
+		return;
+	}
+	hbuf[1 + len] = ']';
+
+	err = golioth_stream_set_async(client,
+				       HEALTH_STREAM_PATH,
+				       GOLIOTH_CONTENT_TYPE_JSON,
+				       hbuf,
+				       len + 2,
+				       async_error_handler,
+				       NULL);
+	if (err) {
+		LOG_ERR("Failed to send bus health to Golioth: %d", err);
+	}
+}
+#endif /* CONFIG_APP_BUS_HEALTH_STREAM */
+
+static void sensor_stats_report(void)
+{
+	static int64_t last_report_ms;
+	int64_t now = k_uptime_get();
+
+	if (now - last_report_ms < CONFIG_APP_BUS_REPORT_INTERVAL_S * MSEC_PER_SEC) {
+		return;
+	}
+	last_report_ms = now;
+
+	app_bus_report();
+
+	if (get_rbe_heartbeat_s()) {
+		LOG_INF("Report-by-exception: %u records sent, %u suppressed, %u/%u metrics sent",
+			rbe_stats.records_sent, rbe_stats.records_suppressed, rbe_stats.metrics_sent,
+			rbe_stats.metrics_sent + rbe_stats.metrics_suppressed);
+	}
+
+	if (golioth_client_is_connected(client)) {
+		app_state_report_bus();
+		IF_ENABLED(CONFIG_APP_BUS_HEALTH_STREAM, (sensor_health_stream();));
+	}
 }
 
 /* This will be called by the main() loop */
 /* Do all of your work here! */
 void app_sensors_read_and_stream(void)
 {
+	const struct zbus_channel *chan;
+	uint32_t loop_start;
+	bool urgent = false;
 	int err;
-	char json_buf[1024];
-	static uint8_t qm30vt2_unit_id = 1;
-	struct qm30vt2_measurement meas = {0};
+
+	/* Wait for a sample, but wake up at least once per LOOP_DELAY_S for uploads
+	 * that are due by age and for the statistics reports
+	 */
+	err = zbus_sub_wait_msg(&sensors_sub, &chan, &sensors_msg, K_SECONDS(get_loop_delay_s()));
+	loop_start = k_cycle_get_32();
 
 	/* Golioth custom hardware for demos */
 	IF_ENABLED(CONFIG_ALUDEL_BATTERY_MONITOR, (
 		read_and_report_battery(client);
-		IF_ENABLED(CONFIG_LIB_OSTENTUS, (
-			ostentus_slide_set(o_dev, BATTERY_V, get_batt_v_str(), strlen(get_batt_v_str()));
-			ostentus_slide_set(o_dev, BATTERY_LVL, get_batt_lvl_str(),
-					     strlen(get_batt_lvl_str()));
-		));
+		IF_ENABLED(CONFIG_LIB_OSTENTUS, (app_display_refresh();));
 	));
 
-	LOG_INF("Reading temperature & vibration data from QM30VT2 sensor");
-
-	err = qm30vt2_read_data(client_iface, qm30vt2_unit_id, &meas);
-	if (err) {
-		LOG_ERR("Failed to read QM30VT2 sensor values: %d", err);
-		return;
+	/* Take every sample that is waiting so they are uploaded together */
+	while (err == 0) {
+		sensor_process_msg(chan, &urgent);
+		err = zbus_sub_wait_msg(&sensors_sub, &chan, &sensors_msg, K_NO_WAIT);
 	}
 
-	qm30vt2_log_measurements(&meas);
-
-	/* Send sensor data to Golioth */
+	/* Send buffered sensor data to Golioth */
 	if (golioth_client_is_connected(client)) {
-		/* clang-format off */
-		snprintk(json_buf, sizeof(json_buf), JSON_FMT,
-			/* Temperature */
-			sensor_value_to_double(&meas.temp_c),
-			sensor_value_to_double(&meas.temp_f),
-
-			/* X-Axis Vibration */
-			sensor_value_to_double(&meas.x_acc_cf),
-			sensor_value_to_double(&meas.x_acc_rms_hf),
-			sensor_value_to_double(&meas.x_acc_kurt),
-			sensor_value_to_double(&meas.x_acc_peak),
-			sensor_value_to_double(&meas.x_acc_rms),
-			sensor_value_to_double(&meas.x_vel_peak_freq),
-			sensor_value_to_double(&meas.x_vel_peak_in),
-			sensor_value_to_double(&meas.x_vel_peak_mm),
-			sensor_value_to_double(&meas.x_vel_rms_in),
-			sensor_value_to_double(&meas.x_vel_rms_mm),
-
-			/* Z-Axis Vibration */
-			sensor_value_to_double(&meas.z_acc_cf),
-			sensor_value_to_double(&meas.z_acc_rms_hf),
-			sensor_value_to_double(&meas.z_acc_kurt),
-			sensor_value_to_double(&meas.z_acc_peak),
-			sensor_value_to_double(&meas.z_acc_rms),
-			sensor_value_to_double(&meas.z_vel_peak_freq),
-			sensor_value_to_double(&meas.z_vel_peak_in),
-			sensor_value_to_double(&meas.z_vel_peak_mm),
-			sensor_value_to_double(&meas.z_vel_rms_in),
-			sensor_value_to_double(&meas.z_vel_rms_mm)
-		);
-		/* clang-format on */
-
-		/* LOG_DBG("%s", json_buf); */
-
-		err = golioth_stream_set_async(client,
-					"sensor",
-					GOLIOTH_CONTENT_TYPE_JSON,
-					json_buf,
-					strlen(json_buf),
-					async_error_handler,
-					NULL);
-		if (err) {
-			LOG_ERR("Failed to send sensor data to Golioth: %d", err);
+		/* Acknowledged samples are dropped before deciding whether a flush is due */
+		bool ready = sensor_batch_ready();
+
+		while (ready && app_batch_count() && (urgent || app_batch_flush_due())) {
+			if (sensor_batch_flush()) {
+				break;
+			}
 		}
-	} else {
-		LOG_WRN("Device is not connected to Golioth, unable to send sensor data");
+
+		/* Resume draining if the connection dropped during a previous drain */
+		app_sensors_client_connected();
 	}
 
-	/* Golioth custom hardware for demos */
-	IF_ENABLED(CONFIG_LIB_OSTENTUS, (
-		/* Update slide values on Ostentus
-		 *  -values should be sent as strings
-		 *  -use the enum from app_sensors.h for slide key values
-		 */
-		snprintk(json_buf, sizeof(json_buf), "%.2f F",
-			 sensor_value_to_double(&meas.temp_f));
-		ostentus_slide_set(o_dev, TEMP_F, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.2f C",
-			 sensor_value_to_double(&meas.temp_c));
-		ostentus_slide_set(o_dev, TEMP_C, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.4f in/sec",
-			 sensor_value_to_double(&meas.z_vel_rms_in));
-		ostentus_slide_set(o_dev, Z_VEL_RMS_IN, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f mm/sec",
-			 sensor_value_to_double(&meas.z_vel_rms_mm));
-		ostentus_slide_set(o_dev, Z_VEL_RMS_MM, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.4f in/sec",
-			 sensor_value_to_double(&meas.x_vel_rms_in));
-		ostentus_slide_set(o_dev, X_VEL_RMS_IN, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f mm/sec",
-			 sensor_value_to_double(&meas.x_vel_rms_mm));
-		ostentus_slide_set(o_dev, X_VEL_RMS_MM, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f G",
-			 sensor_value_to_double(&meas.z_acc_peak));
-		ostentus_slide_set(o_dev, Z_ACC_PEAK, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f G",
-			 sensor_value_to_double(&meas.x_acc_peak));
-		ostentus_slide_set(o_dev, X_ACC_PEAK, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.1f Hz",
-			 sensor_value_to_double(&meas.z_vel_peak_freq));
-		ostentus_slide_set(o_dev, Z_VEL_FREQ, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.1f Hz",
-			 sensor_value_to_double(&meas.x_vel_peak_freq));
-		ostentus_slide_set(o_dev, X_VEL_FREQ, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f G",
-			 sensor_value_to_double(&meas.z_acc_rms));
-		ostentus_slide_set(o_dev, Z_ACC_RMS, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f G",
-			 sensor_value_to_double(&meas.x_acc_rms));
-		ostentus_slide_set(o_dev, X_ACC_RMS, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f",
-			 sensor_value_to_double(&meas.z_acc_kurt));
-		ostentus_slide_set(o_dev, Z_ACC_KURT, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f",
-			 sensor_value_to_double(&meas.x_acc_kurt));
-		ostentus_slide_set(o_dev, X_ACC_KURT, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f",
-			 sensor_value_to_double(&meas.z_acc_cf));
-		ostentus_slide_set(o_dev, Z_ACC_CF, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f",
-			 sensor_value_to_double(&meas.x_acc_cf));
-		ostentus_slide_set(o_dev, X_ACC_CF, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.4f in/sec",
-			 sensor_value_to_double(&meas.z_vel_peak_in));
-		ostentus_slide_set(o_dev, Z_VEL_PEAK_IN, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f mm/sec",
-			 sensor_value_to_double(&meas.z_vel_peak_mm));
-		ostentus_slide_set(o_dev, Z_VEL_PEAK_MM, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.4f in/sec",
-			 sensor_value_to_double(&meas.x_vel_peak_in));
-		ostentus_slide_set(o_dev, X_VEL_PEAK_IN, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f mm/sec",
-			 sensor_value_to_double(&meas.x_vel_peak_mm));
-		ostentus_slide_set(o_dev, X_VEL_PEAK_MM, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f G",
-			 sensor_value_to_double(&meas.z_acc_rms_hf));
-		ostentus_slide_set(o_dev, Z_ACC_RMS_HF, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.3f G",
-			 sensor_value_to_double(&meas.x_acc_rms_hf));
-		ostentus_slide_set(o_dev, X_ACC_RMS_HF, json_buf, strlen(json_buf));
-	));
+	sensor_period_report();
+	sensor_startup_report();
+
+	/* Quarantine changes are reported right away rather than with the statistics */
+	if (golioth_client_is_connected(client) && app_bus_health_changed()) {
+		app_state_report_bus();
+	}
+
+	app_bus_loop_done(k_cyc_to_us_floor32(k_cycle_get_32() - loop_start));
+
+	sensor_stats_report();
+}
+
+#ifdef CONFIG_APP_BENCHMARK
+static void bench_record_get(size_t idx, struct sensor_record *record, void *arg)
+{
+	const struct sensor_record *bench = arg;
+
+	*record = *bench;
+	record->ts_ms = 1740000000000LL + idx * MSEC_PER_SEC;
+}
+
+int app_sensors_encode(const struct qm30vt2_measurement *meas, uint32_t metrics, size_t count,
+		       uint8_t *buf, size_t len)
+{
+	struct sensor_record bench = {
+		.meas = meas,
+		.unit_id = APP_BUS_UNIT_ID_MIN,
+		.metrics = metrics,
+	};
+	size_t payload_len;
+	int err;
+
+	err = sensor_payload_encode(bench_record_get, &bench, count, buf, len, &payload_len);
+
+	return err ? err : payload_len;
 }
+#endif /* CONFIG_APP_BENCHMARK */
 
 void app_sensors_set_client(struct golioth_client *sensors_client)
 {
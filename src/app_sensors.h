@@ -16,58 +16,50 @@
 
 #include <golioth/client.h>
 
+#include "qm30vt2.h"
+
 void app_sensors_init(void);
 void app_sensors_set_client(struct golioth_client *sensors_client);
+
+/**
+ * Process the poll results of the acquisition thread (see app_acq.h) and upload
+ * them. Blocks until a result arrives or one LOOP_DELAY_S has passed.
+ */
 void app_sensors_read_and_stream(void);
 
-#define LABEL_TEMP	   "Temperature"
-#define LABEL_Z_VEL_RMS	   "Z RMS V"
-#define LABEL_X_VEL_RMS	   "X RMS V"
-#define LABEL_Z_ACC_PEAK   "Z Peak A"
-#define LABEL_X_ACC_PEAK   "X Peak A"
-#define LABEL_Z_VEL_FREQ   "Z Peak F"
-#define LABEL_X_VEL_FREQ   "X Peak F"
-#define LABEL_Z_ACC_RMS	   "Z RMS A"
-#define LABEL_X_ACC_RMS	   "X RMS A"
-#define LABEL_Z_ACC_KURT   "Z Kurt"
-#define LABEL_X_ACC_KURT   "X Kurt"
-#define LABEL_Z_ACC_CF	   "Z CF"
-#define LABEL_X_ACC_CF	   "X CF"
-#define LABEL_Z_VEL_PEAK   "Z Peak Vel"
-#define LABEL_X_VEL_PEAK   "X Peak Vel"
-#define LABEL_Z_ACC_RMS_HF "Z RMS HF A"
-#define LABEL_X_ACC_RMS_HF "X RMS HF A"
-#define LABEL_BATTERY	   "Battery"
-#define LABEL_FIRMWARE	   "Firmware"
-#define SUMMARY_TITLE	   "Modbus RD"
+/**
+ * Notify the sensor module that the Golioth client connected so samples queued
+ * in flash while offline can be drained.
+ */
+void app_sensors_client_connected(void);
+
+#ifdef CONFIG_APP_BENCHMARK
+#include <stdint.h>
+
+/* Hook for the acquisition benchmark, see app_bench.h */
+/**
+ * Encode count copies of a record with the metrics of meas in a mask as one
+ * stream payload, the way batched samples are uploaded. Returns the payload
+ * length or a negative error.
+ */
+int app_sensors_encode(const struct qm30vt2_measurement *meas, uint32_t metrics, size_t count,
+		       uint8_t *buf, size_t len);
+#endif /* CONFIG_APP_BENCHMARK */
+
+#define LABEL_BATTERY  "Battery"
+#define LABEL_FIRMWARE "Firmware"
+#define SUMMARY_TITLE  "Modbus RD"
+
+#define SLIDE_KEY(name, NAME, ...) NAME,
 
 /**
  * Each Ostentus slide needs a unique key. You may add additional slides by
- * inserting elements with the name of your choice to this enum.
+ * inserting elements with the name of your choice to this enum. Keys of the
+ * sensor metrics come first and are generated from QM30VT2_METRICS, which also
+ * holds their labels.
  */
 typedef enum {
-	TEMP_F,
-	TEMP_C,
-	Z_VEL_RMS_IN,
-	Z_VEL_RMS_MM,
-	X_VEL_RMS_IN,
-	X_VEL_RMS_MM,
-	Z_ACC_PEAK,
-	X_ACC_PEAK,
-	Z_VEL_FREQ,
-	X_VEL_FREQ,
-	Z_ACC_RMS,
-	X_ACC_RMS,
-	Z_ACC_KURT,
-	X_ACC_KURT,
-	Z_ACC_CF,
-	X_ACC_CF,
-	Z_VEL_PEAK_IN,
-	Z_VEL_PEAK_MM,
-	X_VEL_PEAK_IN,
-	X_VEL_PEAK_MM,
-	Z_ACC_RMS_HF,
-	X_ACC_RMS_HF,
+	QM30VT2_METRICS(SLIDE_KEY)
 #ifdef CONFIG_ALUDEL_BATTERY_MONITOR
 	BATTERY_V,
 	BATTERY_LVL,
@@ -7,28 +7,528 @@
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(app_settings, LOG_LEVEL_DBG);
 
+#include <string.h>
 #include <golioth/client.h>
 #include <golioth/settings.h>
+#include <zephyr/settings/settings.h>
 #include "main.h"
+#include "app_acq.h"
+#include "app_fixed.h"
 #include "app_settings.h"
+#include "qm30vt2.h"
+
+/* Deadbands and alarm limits are logged to this many decimals */
+#define SETTING_LOG_DECIMALS 4
+
+/* Values received from the Settings service are cached in flash under this subtree */
+#define SETTINGS_CACHE_ROOT "app/cfg"
 
 static int32_t _loop_delay_s = 60;
 #define LOOP_DELAY_S_MAX 43200
 #define LOOP_DELAY_S_MIN 1
 
+static int32_t _batch_flush_count = CONFIG_APP_BATCH_FLUSH_COUNT;
+#define BATCH_FLUSH_COUNT_MAX CONFIG_APP_BATCH_CAPACITY
+#define BATCH_FLUSH_COUNT_MIN 1
+
+static int32_t _batch_max_age_s = CONFIG_APP_BATCH_MAX_AGE_S;
+#define BATCH_MAX_AGE_S_MAX 43200
+#define BATCH_MAX_AGE_S_MIN 0
+
+static float _rbe_deadband[APP_DEADBAND_COUNT] = {
+	[APP_DEADBAND_TEMP] = 0.5f,
+	[APP_DEADBAND_ACC] = 0.01f,
+	[APP_DEADBAND_VEL] = 0.1f,
+	[APP_DEADBAND_FREQ] = 1.0f,
+	[APP_DEADBAND_SHAPE] = 0.1f,
+};
+
+static const char *const rbe_deadband_keys[APP_DEADBAND_COUNT] = {
+	[APP_DEADBAND_TEMP] = "RBE_TEMP_DEADBAND",
+	[APP_DEADBAND_ACC] = "RBE_ACC_DEADBAND",
+	[APP_DEADBAND_VEL] = "RBE_VEL_DEADBAND",
+	[APP_DEADBAND_FREQ] = "RBE_FREQ_DEADBAND",
+	[APP_DEADBAND_SHAPE] = "RBE_SHAPE_DEADBAND",
+};
+
+static int32_t _rbe_deadband_pct = 5;
+#define RBE_DEADBAND_PCT_MAX 100
+#define RBE_DEADBAND_PCT_MIN 0
+
+static int32_t _rbe_heartbeat_s;
+#define RBE_HEARTBEAT_S_MAX 86400
+#define RBE_HEARTBEAT_S_MIN 0
+
+static float _alarm_limit[APP_ALARM_LIMIT_COUNT] = {
+	[APP_ALARM_LIMIT_KURTOSIS] = 5.0f,
+	[APP_ALARM_LIMIT_CREST_FACTOR] = 6.0f,
+	[APP_ALARM_LIMIT_HF_RMS] = 2.0f,
+	[APP_ALARM_LIMIT_TEMP] = 80.0f,
+};
+
+static const char *const alarm_limit_keys[APP_ALARM_LIMIT_COUNT] = {
+	[APP_ALARM_LIMIT_KURTOSIS] = "ALARM_KURTOSIS",
+	[APP_ALARM_LIMIT_CREST_FACTOR] = "ALARM_CREST_FACTOR",
+	[APP_ALARM_LIMIT_HF_RMS] = "ALARM_HF_RMS_G",
+	[APP_ALARM_LIMIT_TEMP] = "ALARM_TEMP_C",
+};
+
+static int32_t _alarm_machine_class = 2;
+#define ALARM_MACHINE_CLASS_MAX 4
+#define ALARM_MACHINE_CLASS_MIN 1
+
+static int32_t _alarm_hysteresis_pct = 10;
+#define ALARM_HYSTERESIS_PCT_MAX 50
+#define ALARM_HYSTERESIS_PCT_MIN 0
+
+static int32_t _adaptive_min_period_s;
+#define ADAPTIVE_MIN_PERIOD_S_MAX 43200
+#define ADAPTIVE_MIN_PERIOD_S_MIN 0
+
+static int32_t _adaptive_max_period_s = 600;
+#define ADAPTIVE_MAX_PERIOD_S_MAX 43200
+#define ADAPTIVE_MAX_PERIOD_S_MIN 1
+
+static int32_t _adaptive_change_pct = 20;
+#define ADAPTIVE_CHANGE_PCT_MAX 1000
+#define ADAPTIVE_CHANGE_PCT_MIN 1
+
+static int32_t _adaptive_speedup_factor = 4;
+#define ADAPTIVE_SPEEDUP_FACTOR_MAX 16
+#define ADAPTIVE_SPEEDUP_FACTOR_MIN 1
+
+static int32_t _adaptive_relax_pct = 25;
+#define ADAPTIVE_RELAX_PCT_MAX 100
+#define ADAPTIVE_RELAX_PCT_MIN 1
+
+static int32_t _summary_window_s;
+#define SUMMARY_WINDOW_S_MAX 86400
+#define SUMMARY_WINDOW_S_MIN 0
+
+static uint32_t _metric_mask = QM30VT2_METRICS_ALL;
+#define METRICS_MASK_MAX QM30VT2_METRICS_ALL
+#define METRICS_MASK_MIN 1
+
+static int32_t _modbus_baud = 19200;
+#define MODBUS_BAUD_MAX 115200
+#define MODBUS_BAUD_MIN 1200
+
+/* Standard rates accepted by MODBUS_BAUD */
+static const int32_t modbus_bauds[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+
+static int32_t _modbus_parity = UART_CFG_PARITY_NONE;
+#define MODBUS_PARITY_MAX UART_CFG_PARITY_EVEN
+#define MODBUS_PARITY_MIN UART_CFG_PARITY_NONE
+
+static int32_t _modbus_timeout_ms = CONFIG_APP_MODBUS_TIMEOUT_MS;
+#define MODBUS_TIMEOUT_MS_MAX 5000
+#define MODBUS_TIMEOUT_MS_MIN 0
+
+/* Settings cached in flash, each value is 32 bits wide */
+#define SETTING_SIZE sizeof(int32_t)
+BUILD_ASSERT(sizeof(float) == SETTING_SIZE);
+
+static const struct {
+	const char *key;
+	void *value;
+} cached_settings[] = {
+	{"LOOP_DELAY_S", &_loop_delay_s},
+	{"BATCH_FLUSH_COUNT", &_batch_flush_count},
+	{"BATCH_MAX_AGE_S", &_batch_max_age_s},
+	{"RBE_TEMP_DEADBAND", &_rbe_deadband[APP_DEADBAND_TEMP]},
+	{"RBE_ACC_DEADBAND", &_rbe_deadband[APP_DEADBAND_ACC]},
+	{"RBE_VEL_DEADBAND", &_rbe_deadband[APP_DEADBAND_VEL]},
+	{"RBE_FREQ_DEADBAND", &_rbe_deadband[APP_DEADBAND_FREQ]},
+	{"RBE_SHAPE_DEADBAND", &_rbe_deadband[APP_DEADBAND_SHAPE]},
+	{"RBE_DEADBAND_PCT", &_rbe_deadband_pct},
+	{"RBE_HEARTBEAT_S", &_rbe_heartbeat_s},
+	{"ALARM_KURTOSIS", &_alarm_limit[APP_ALARM_LIMIT_KURTOSIS]},
+	{"ALARM_CREST_FACTOR", &_alarm_limit[APP_ALARM_LIMIT_CREST_FACTOR]},
+	{"ALARM_HF_RMS_G", &_alarm_limit[APP_ALARM_LIMIT_HF_RMS]},
+	{"ALARM_TEMP_C", &_alarm_limit[APP_ALARM_LIMIT_TEMP]},
+	{"ALARM_MACHINE_CLASS", &_alarm_machine_class},
+	{"ALARM_HYSTERESIS_PCT", &_alarm_hysteresis_pct},
+	{"ADAPTIVE_MIN_PERIOD_S", &_adaptive_min_period_s},
+	{"ADAPTIVE_MAX_PERIOD_S", &_adaptive_max_period_s},
+	{"ADAPTIVE_CHANGE_PCT", &_adaptive_change_pct},
+	{"ADAPTIVE_SPEEDUP_FACTOR", &_adaptive_speedup_factor},
+	{"ADAPTIVE_RELAX_PCT", &_adaptive_relax_pct},
+	{"SUMMARY_WINDOW_S", &_summary_window_s},
+	{"METRICS_MASK", &_metric_mask},
+	{"MODBUS_BAUD", &_modbus_baud},
+	{"MODBUS_PARITY", &_modbus_parity},
+	{"MODBUS_TIMEOUT_MS", &_modbus_timeout_ms},
+};
+
+/* Every cached setting is also registered with the Golioth settings service */
+BUILD_ASSERT(ARRAY_SIZE(cached_settings) <= CONFIG_GOLIOTH_MAX_NUM_SETTINGS,
+	     "Raise CONFIG_GOLIOTH_MAX_NUM_SETTINGS in prj.conf");
+
+static size_t cached_count;
+
+static int cache_settings_set(const char *name, size_t len, settings_read_cb read_cb,
+			      void *cb_arg)
+{
+	const char *next;
+	uint8_t value[SETTING_SIZE];
+	ssize_t rc;
+
+	for (size_t i = 0; i < ARRAY_SIZE(cached_settings); i++) {
+		if (!settings_name_steq(name, cached_settings[i].key, &next) || next) {
+			continue;
+		}
+
+		if (len != SETTING_SIZE) {
+			return -EINVAL;
+		}
+
+		rc = read_cb(cb_arg, value, sizeof(value));
+		if (rc < 0) {
+			return rc;
+		}
+
+		memcpy(cached_settings[i].value, value, SETTING_SIZE);
+		cached_count++;
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_settings, SETTINGS_CACHE_ROOT, NULL, cache_settings_set, NULL,
+			       NULL);
+
+/* Apply a value received from the Settings service and cache it if it changed. The
+ * service sends every setting after each connection, so unchanged values cost no
+ * flash writes.
+ */
+static void setting_apply(void *value, const void *new_value)
+{
+	char path[SETTINGS_MAX_NAME_LEN + 1];
+	int err;
+
+	if (memcmp(value, new_value, SETTING_SIZE) == 0) {
+		return;
+	}
+
+	memcpy(value, new_value, SETTING_SIZE);
+
+	for (size_t i = 0; i < ARRAY_SIZE(cached_settings); i++) {
+		if (cached_settings[i].value != value) {
+			continue;
+		}
+
+		snprintk(path, sizeof(path), SETTINGS_CACHE_ROOT "/%s", cached_settings[i].key);
+		err = settings_save_one(path, value, SETTING_SIZE);
+		if (err) {
+			LOG_WRN("Failed to cache %s: %d", cached_settings[i].key, err);
+		}
+		return;
+	}
+}
+
+int app_settings_load(void)
+{
+	int err;
+
+	/* Counted again if the subtree was already loaded with the sample credentials */
+	cached_count = 0;
+
+	err = settings_load_subtree(SETTINGS_CACHE_ROOT);
+
+	if (err) {
+		LOG_WRN("Failed to load cached settings: %d", err);
+		return err;
+	}
+
+	if (cached_count) {
+		LOG_INF("Applied %zu cached settings, loop delay %d seconds", cached_count,
+			_loop_delay_s);
+	}
+
+	/* The Modbus client was set up with the defaults */
+	app_acq_serial_update();
+
+	return 0;
+}
+
 int32_t get_loop_delay_s(void)
 {
 	return _loop_delay_s;
 }
 
+int32_t get_batch_flush_count(void)
+{
+	return _batch_flush_count;
+}
+
+int32_t get_batch_max_age_s(void)
+{
+	return _batch_max_age_s;
+}
+
+float get_rbe_deadband(enum app_deadband group)
+{
+	return _rbe_deadband[group];
+}
+
+int32_t get_rbe_deadband_pct(void)
+{
+	return _rbe_deadband_pct;
+}
+
+int32_t get_rbe_heartbeat_s(void)
+{
+	return _rbe_heartbeat_s;
+}
+
+float get_alarm_limit(enum app_alarm_limit limit)
+{
+	return _alarm_limit[limit];
+}
+
+int32_t get_alarm_machine_class(void)
+{
+	return _alarm_machine_class;
+}
+
+int32_t get_alarm_hysteresis_pct(void)
+{
+	return _alarm_hysteresis_pct;
+}
+
+int32_t get_adaptive_min_period_s(void)
+{
+	return _adaptive_min_period_s;
+}
+
+int32_t get_adaptive_max_period_s(void)
+{
+	return _adaptive_max_period_s;
+}
+
+int32_t get_adaptive_change_pct(void)
+{
+	return _adaptive_change_pct;
+}
+
+int32_t get_adaptive_speedup_factor(void)
+{
+	return _adaptive_speedup_factor;
+}
+
+int32_t get_adaptive_relax_pct(void)
+{
+	return _adaptive_relax_pct;
+}
+
+int32_t get_summary_window_s(void)
+{
+	return _summary_window_s;
+}
+
+uint32_t get_metric_mask(void)
+{
+	return _metric_mask;
+}
+
+uint32_t get_modbus_baud(void)
+{
+	return _modbus_baud;
+}
+
+enum uart_config_parity get_modbus_parity(void)
+{
+	return _modbus_parity;
+}
+
+const char *app_settings_parity_name(enum uart_config_parity parity)
+{
+	static const char *const parity_names[] = {
+		[UART_CFG_PARITY_NONE] = "none",
+		[UART_CFG_PARITY_ODD] = "odd",
+		[UART_CFG_PARITY_EVEN] = "even",
+	};
+
+	return (parity < ARRAY_SIZE(parity_names)) ? parity_names[parity] : "unknown";
+}
+
+int32_t get_modbus_timeout_ms(void)
+{
+	return _modbus_timeout_ms;
+}
+
 static enum golioth_settings_status on_loop_delay_setting(int32_t new_value, void *arg)
 {
-	_loop_delay_s = new_value;
+	setting_apply(&_loop_delay_s, &new_value);
 	LOG_INF("Set loop delay to %i seconds", new_value);
 	wake_system_thread();
 	return GOLIOTH_SETTINGS_SUCCESS;
 }
 
+static enum golioth_settings_status on_batch_flush_count_setting(int32_t new_value, void *arg)
+{
+	setting_apply(&_batch_flush_count, &new_value);
+	LOG_INF("Set batch flush count to %i samples", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_batch_max_age_setting(int32_t new_value, void *arg)
+{
+	setting_apply(&_batch_max_age_s, &new_value);
+	LOG_INF("Set batch max age to %i seconds", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+/* Float settings are logged with integer formatting, see app_fixed.h */
+static void log_float_setting(const char *key, float value)
+{
+	char sbuf[APP_FIXED_STR_LEN];
+
+	app_fixed_format(sbuf, sizeof(sbuf), app_fixed_from_float(value, SETTING_LOG_DECIMALS),
+			 SETTING_LOG_DECIMALS);
+	LOG_INF("Set %s to %s", key, sbuf);
+}
+
+static enum golioth_settings_status on_rbe_deadband_setting(float new_value, void *arg)
+{
+	enum app_deadband group = (enum app_deadband)(uintptr_t)arg;
+
+	if (new_value < 0.0f) {
+		return GOLIOTH_SETTINGS_VALUE_OUTSIDE_RANGE;
+	}
+
+	setting_apply(&_rbe_deadband[group], &new_value);
+	log_float_setting(rbe_deadband_keys[group], new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_rbe_deadband_pct_setting(int32_t new_value, void *arg)
+{
+	setting_apply(&_rbe_deadband_pct, &new_value);
+	LOG_INF("Set report-by-exception deadband to %i percent", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_rbe_heartbeat_setting(int32_t new_value, void *arg)
+{
+	setting_apply(&_rbe_heartbeat_s, &new_value);
+	if (new_value) {
+		LOG_INF("Set report-by-exception heartbeat to %i seconds", new_value);
+	} else {
+		LOG_INF("Report-by-exception disabled");
+	}
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_alarm_limit_setting(float new_value, void *arg)
+{
+	enum app_alarm_limit limit = (enum app_alarm_limit)(uintptr_t)arg;
+
+	if (new_value < 0.0f) {
+		return GOLIOTH_SETTINGS_VALUE_OUTSIDE_RANGE;
+	}
+
+	setting_apply(&_alarm_limit[limit], &new_value);
+	log_float_setting(alarm_limit_keys[limit], new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_alarm_machine_class_setting(int32_t new_value, void *arg)
+{
+	setting_apply(&_alarm_machine_class, &new_value);
+	LOG_INF("Set ISO 10816 machine class to %i", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_alarm_hysteresis_setting(int32_t new_value, void *arg)
+{
+	setting_apply(&_alarm_hysteresis_pct, &new_value);
+	LOG_INF("Set alarm hysteresis to %i percent", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_adaptive_setting(int32_t new_value, void *arg)
+{
+	int32_t *value = arg;
+
+	setting_apply(value, &new_value);
+	LOG_INF("Set adaptive sampling parameter to %i", new_value);
+	/* Apply a new period range without waiting out the current one */
+	wake_system_thread();
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_summary_window_setting(int32_t new_value, void *arg)
+{
+	setting_apply(&_summary_window_s, &new_value);
+	if (new_value) {
+		LOG_INF("Set summary window to %i seconds", new_value);
+	} else {
+		LOG_INF("Streaming raw samples");
+	}
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_metric_mask_setting(int32_t new_value, void *arg)
+{
+	uint16_t first;
+	uint16_t count = qm30vt2_reg_span(new_value, &first);
+
+	setting_apply(&_metric_mask, &new_value);
+	LOG_INF("Set metric mask to 0x%06x, %u of %u metrics in %u registers", new_value,
+		popcount(new_value), QM30VT2_METRIC_COUNT, count);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_modbus_baud_setting(int32_t new_value, void *arg)
+{
+	bool valid = false;
+
+	for (size_t i = 0; i < ARRAY_SIZE(modbus_bauds); i++) {
+		valid = valid || (modbus_bauds[i] == new_value);
+	}
+	if (!valid) {
+		return GOLIOTH_SETTINGS_VALUE_OUTSIDE_RANGE;
+	}
+
+	setting_apply(&_modbus_baud, &new_value);
+	LOG_INF("Set Modbus baud rate to %i", new_value);
+	app_acq_serial_update();
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_modbus_parity_setting(int32_t new_value, void *arg)
+{
+	setting_apply(&_modbus_parity, &new_value);
+	LOG_INF("Set Modbus parity to %s", app_settings_parity_name(new_value));
+	app_acq_serial_update();
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_modbus_timeout_setting(int32_t new_value, void *arg)
+{
+	if ((new_value != 0) && (new_value < CONFIG_APP_MODBUS_TIMEOUT_MIN_MS)) {
+		return GOLIOTH_SETTINGS_VALUE_OUTSIDE_RANGE;
+	}
+
+	setting_apply(&_modbus_timeout_ms, &new_value);
+	if (new_value) {
+		LOG_INF("Set Modbus response timeout to %i ms", new_value);
+	} else {
+		LOG_INF("Modbus response timeout calibrated automatically");
+	}
+	app_acq_serial_update();
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static void settings_log_if_register_failure(int err)
+{
+	if (err) {
+		LOG_ERR("Failed to register settings callback: %d", err);
+	}
+}
+
 int app_settings_register(struct golioth_client *client)
 {
 	struct golioth_settings *settings = golioth_settings_init(client);
@@ -39,10 +539,151 @@ int app_settings_register(struct golioth_client *client)
 							   LOOP_DELAY_S_MAX,
 							   on_loop_delay_setting,
 							   NULL);
+	settings_log_if_register_failure(err);
 
-	if (err) {
-		LOG_ERR("Failed to register settings callback: %d", err);
+	err = golioth_settings_register_int_with_range(settings,
+						       "BATCH_FLUSH_COUNT",
+						       BATCH_FLUSH_COUNT_MIN,
+						       BATCH_FLUSH_COUNT_MAX,
+						       on_batch_flush_count_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "BATCH_MAX_AGE_S",
+						       BATCH_MAX_AGE_S_MIN,
+						       BATCH_MAX_AGE_S_MAX,
+						       on_batch_max_age_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	for (int i = 0; i < APP_DEADBAND_COUNT; i++) {
+		err = golioth_settings_register_float(settings,
+						      rbe_deadband_keys[i],
+						      on_rbe_deadband_setting,
+						      (void *)(uintptr_t)i);
+		settings_log_if_register_failure(err);
 	}
 
+	err = golioth_settings_register_int_with_range(settings,
+						       "RBE_DEADBAND_PCT",
+						       RBE_DEADBAND_PCT_MIN,
+						       RBE_DEADBAND_PCT_MAX,
+						       on_rbe_deadband_pct_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "RBE_HEARTBEAT_S",
+						       RBE_HEARTBEAT_S_MIN,
+						       RBE_HEARTBEAT_S_MAX,
+						       on_rbe_heartbeat_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	for (int i = 0; i < APP_ALARM_LIMIT_COUNT; i++) {
+		err = golioth_settings_register_float(settings,
+						      alarm_limit_keys[i],
+						      on_alarm_limit_setting,
+						      (void *)(uintptr_t)i);
+		settings_log_if_register_failure(err);
+	}
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "ALARM_MACHINE_CLASS",
+						       ALARM_MACHINE_CLASS_MIN,
+						       ALARM_MACHINE_CLASS_MAX,
+						       on_alarm_machine_class_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "ALARM_HYSTERESIS_PCT",
+						       ALARM_HYSTERESIS_PCT_MIN,
+						       ALARM_HYSTERESIS_PCT_MAX,
+						       on_alarm_hysteresis_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "ADAPTIVE_MIN_PERIOD_S",
+						       ADAPTIVE_MIN_PERIOD_S_MIN,
+						       ADAPTIVE_MIN_PERIOD_S_MAX,
+						       on_adaptive_setting,
+						       &_adaptive_min_period_s);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "ADAPTIVE_MAX_PERIOD_S",
+						       ADAPTIVE_MAX_PERIOD_S_MIN,
+						       ADAPTIVE_MAX_PERIOD_S_MAX,
+						       on_adaptive_setting,
+						       &_adaptive_max_period_s);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "ADAPTIVE_CHANGE_PCT",
+						       ADAPTIVE_CHANGE_PCT_MIN,
+						       ADAPTIVE_CHANGE_PCT_MAX,
+						       on_adaptive_setting,
+						       &_adaptive_change_pct);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "ADAPTIVE_SPEEDUP_FACTOR",
+						       ADAPTIVE_SPEEDUP_FACTOR_MIN,
+						       ADAPTIVE_SPEEDUP_FACTOR_MAX,
+						       on_adaptive_setting,
+						       &_adaptive_speedup_factor);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "ADAPTIVE_RELAX_PCT",
+						       ADAPTIVE_RELAX_PCT_MIN,
+						       ADAPTIVE_RELAX_PCT_MAX,
+						       on_adaptive_setting,
+						       &_adaptive_relax_pct);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "SUMMARY_WINDOW_S",
+						       SUMMARY_WINDOW_S_MIN,
+						       SUMMARY_WINDOW_S_MAX,
+						       on_summary_window_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "METRICS_MASK",
+						       METRICS_MASK_MIN,
+						       METRICS_MASK_MAX,
+						       on_metric_mask_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "MODBUS_BAUD",
+						       MODBUS_BAUD_MIN,
+						       MODBUS_BAUD_MAX,
+						       on_modbus_baud_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "MODBUS_PARITY",
+						       MODBUS_PARITY_MIN,
+						       MODBUS_PARITY_MAX,
+						       on_modbus_parity_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
+	err = golioth_settings_register_int_with_range(settings,
+						       "MODBUS_TIMEOUT_MS",
+						       MODBUS_TIMEOUT_MS_MIN,
+						       MODBUS_TIMEOUT_MS_MAX,
+						       on_modbus_timeout_setting,
+						       NULL);
+	settings_log_if_register_failure(err);
+
 	return err;
 }
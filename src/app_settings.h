@@ -10,7 +10,18 @@
  *
  * In this demonstration, the device looks for the `LOOP_DELAY_S` key from the
  * Settings Service and uses this value to determine the delay between sensor
- * reads (the period of sleep in the loop of `main.c`.
+ * reads (the period of sleep in the loop of `main.c`. The `BATCH_FLUSH_COUNT`
+ * and `BATCH_MAX_AGE_S` keys control how many samples are collected before
+ * they are uploaded together. The `RBE_*` keys configure report-by-exception
+ * and the `ALARM_*` keys the on-device alarm rules. The `ADAPTIVE_*` keys
+ * control the adaptive poll period and `SUMMARY_WINDOW_S` selects between raw
+ * samples and windowed summary statistics. `METRICS_MASK` selects the QM30VT2
+ * metrics that are read, decoded and sent. The `MODBUS_*` keys set the serial
+ * parameters and response timeout of the Modbus client, see app_acq.h.
+ *
+ * Every value received is cached in flash when it changes and applied again at
+ * boot with app_settings_load(), so the device samples with its last settings
+ * before the Settings Service is reached.
  *
  * https://docs.golioth.io/firmware/zephyr-device-sdk/device-settings-service
  */
@@ -20,8 +31,67 @@
 
 #include <stdint.h>
 #include <golioth/client.h>
+#include <zephyr/drivers/uart.h>
 
 int32_t get_loop_delay_s(void);
+int32_t get_batch_flush_count(void);
+int32_t get_batch_max_age_s(void);
+
+/* Groups of QM30VT2 metrics sharing a report-by-exception deadband */
+enum app_deadband {
+	APP_DEADBAND_TEMP,
+	APP_DEADBAND_ACC,
+	APP_DEADBAND_VEL,
+	APP_DEADBAND_FREQ,
+	APP_DEADBAND_SHAPE,
+	APP_DEADBAND_COUNT,
+};
+
+/* Absolute deadband of a metric group, in °C, G, mm/s, Hz or unitless */
+float get_rbe_deadband(enum app_deadband group);
+int32_t get_rbe_deadband_pct(void);
+/* Interval in seconds between full records, 0 if report-by-exception is off */
+int32_t get_rbe_heartbeat_s(void);
+
+/* Single-threshold alarm rules */
+enum app_alarm_limit {
+	APP_ALARM_LIMIT_KURTOSIS,
+	APP_ALARM_LIMIT_CREST_FACTOR,
+	APP_ALARM_LIMIT_HF_RMS,
+	APP_ALARM_LIMIT_TEMP,
+	APP_ALARM_LIMIT_COUNT,
+};
+
+/* Alarm threshold of a rule, 0 if the rule is disabled */
+float get_alarm_limit(enum app_alarm_limit limit);
+/* ISO 10816 machine class, 1 (class I) to 4 (class IV) */
+int32_t get_alarm_machine_class(void);
+int32_t get_alarm_hysteresis_pct(void);
+
+/* Shortest adaptive poll period in seconds, 0 if adaptive sampling is off */
+int32_t get_adaptive_min_period_s(void);
+int32_t get_adaptive_max_period_s(void);
+int32_t get_adaptive_change_pct(void);
+int32_t get_adaptive_speedup_factor(void);
+int32_t get_adaptive_relax_pct(void);
+
+/* Summary window length in seconds, 0 to stream raw samples */
+int32_t get_summary_window_s(void);
+
+/* Bitmask of the QM30VT2 metrics to poll, bit n is entry n of QM30VT2_METRICS */
+uint32_t get_metric_mask(void);
+
+/* Serial parameters of the Modbus client, shared by every unit on the bus */
+uint32_t get_modbus_baud(void);
+enum uart_config_parity get_modbus_parity(void);
+/* Name of a MODBUS_PARITY value for logs, e.g. "none" */
+const char *app_settings_parity_name(enum uart_config_parity parity);
+/* Modbus response timeout in milliseconds, 0 to calibrate it automatically */
+int32_t get_modbus_timeout_ms(void);
+
+/** Apply the settings cached in flash, before connecting to Golioth. */
+int app_settings_load(void);
+
 int app_settings_register(struct golioth_client *client);
 
 #endif /* __APP_SETTINGS_H__ */
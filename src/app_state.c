@@ -13,10 +13,29 @@ LOG_MODULE_REGISTER(app_state, LOG_LEVEL_DBG);
 #include <zephyr/kernel.h>
 #include "json_helper.h"
 
+#include "app_boot.h"
+#include "app_bus.h"
+#ifdef CONFIG_APP_REGMAP
+#include "app_regmap.h"
+#endif
 #include "app_state.h"
 #include "app_sensors.h"
 
-#define DEVICE_STATE_FMT "{\"example_int0\":%d,\"example_int1\":%d}"
+#define DEVICE_STATE_FMT "{\"example_int0\":%d,\"example_int1\":%d,\"units\":%s}"
+
+/* Longest "units" array reported in the actual state */
+#define UNITS_JSON_MAX_LEN                                                                         \
+	(CONFIG_APP_BUS_MAX_UNITS *                                                                \
+		 sizeof("{\"id\":247,\"period_s\":4294967295,"                                     \
+			"\"effective_period_s\":4294967295,\"regmap\":true},") +                   \
+	 2)
+
+/* Longest bus statistics object */
+#define BUS_JSON_MAX_LEN                                                                           \
+	(128 + CONFIG_APP_BUS_MAX_UNITS *                                                          \
+		      sizeof("{\"id\":247,\"health\":\"quarantined\",\"stale_s\":-2147483648,"     \
+			     "\"polls\":4294967295,\"failures\":4294967295,"                       \
+			     "\"retries\":4294967295},"))
 
 uint32_t _example_int0;
 uint32_t _example_int1 = 1;
@@ -41,9 +60,9 @@ int app_state_reset_desired(void)
 {
 	LOG_INF("Resetting \"%s\" LightDB State endpoint to defaults.", APP_STATE_DESIRED_ENDP);
 
-	char sbuf[sizeof(DEVICE_STATE_FMT) + 4]; /* space for two "-1" values */
+	char sbuf[sizeof(DEVICE_STATE_FMT) + 4]; /* space for two "-1" values and "[]" */
 
-	snprintk(sbuf, sizeof(sbuf), DEVICE_STATE_FMT, -1, -1);
+	snprintk(sbuf, sizeof(sbuf), DEVICE_STATE_FMT, -1, -1, "[]");
 
 	int err;
 	err = golioth_lightdb_set_async(client,
@@ -62,11 +81,17 @@ int app_state_reset_desired(void)
 int app_state_update_actual(void)
 {
 
-	char sbuf[sizeof(DEVICE_STATE_FMT) + 10]; /* space for uint16 values */
+	char units[UNITS_JSON_MAX_LEN];
+	char sbuf[sizeof(DEVICE_STATE_FMT) + 10 + sizeof(units)]; /* space for uint16 values */
+	int err;
 
-	snprintk(sbuf, sizeof(sbuf), DEVICE_STATE_FMT, _example_int0, _example_int1);
+	err = app_bus_units_to_json(units, sizeof(units));
+	if (err < 0) {
+		LOG_ERR("Unable to encode bus units: %d", err);
+		return err;
+	}
 
-	int err;
+	snprintk(sbuf, sizeof(sbuf), DEVICE_STATE_FMT, _example_int0, _example_int1, units);
 
 	err = golioth_lightdb_set_async(client,
 					APP_STATE_ACTUAL_ENDP,
@@ -97,7 +122,8 @@ static void app_state_desired_handler(struct golioth_client *client, enum goliot
 
 	LOG_HEXDUMP_DBG(payload, payload_size, APP_STATE_DESIRED_ENDP);
 
-	struct app_state parsed_state;
+	/* Members missing from an element of an array are not written by the parser */
+	struct app_state parsed_state = {0};
 
 	ret = json_obj_parse((char *)payload, payload_size, app_state_descr,
 			     ARRAY_SIZE(app_state_descr), &parsed_state);
@@ -148,6 +174,33 @@ static void app_state_desired_handler(struct golioth_client *client, enum goliot
 		}
 	}
 
+	if ((ret & 1 << 2) && (parsed_state.units_len > 0)) {
+		/* Process units, the list is applied as a whole or not at all */
+		struct app_bus_unit_cfg cfg[CONFIG_APP_BUS_MAX_UNITS];
+		size_t i;
+
+		for (i = 0; i < parsed_state.units_len; i++) {
+			const struct app_state_unit *unit = &parsed_state.units[i];
+
+			if ((unit->id < APP_BUS_UNIT_ID_MIN) || (unit->id > APP_BUS_UNIT_ID_MAX) ||
+			    (unit->period_s < 0) || (unit->period_s > 43200)) {
+				LOG_ERR("Invalid desired unit: id %d, period_s %d", unit->id,
+					unit->period_s);
+				break;
+			}
+
+			cfg[i].id = unit->id;
+			cfg[i].period_s = unit->period_s;
+			cfg[i].regmap = IS_ENABLED(CONFIG_APP_REGMAP) && unit->regmap;
+		}
+
+		if ((i == parsed_state.units_len) && (app_bus_set_units(cfg, i) == 0)) {
+			LOG_DBG("Validated desired units: %zu", i);
+			++state_change_count;
+		}
+		++desired_processed_count;
+	}
+
 	if (state_change_count) {
 		/* The state was changed, so update the state on the Golioth servers */
 		err = app_state_update_actual();
@@ -164,12 +217,152 @@ static void app_state_desired_handler(struct golioth_client *client, enum goliot
 	}
 }
 
+int app_state_report_bus(void)
+{
+	char sbuf[BUS_JSON_MAX_LEN];
+	int err;
+
+	err = app_bus_stats_to_json(sbuf, sizeof(sbuf));
+	if (err < 0) {
+		LOG_ERR("Unable to encode bus statistics: %d", err);
+		return err;
+	}
+
+	err = golioth_lightdb_set_async(client,
+					APP_STATE_BUS_ENDP,
+					GOLIOTH_CONTENT_TYPE_JSON,
+					sbuf,
+					strlen(sbuf),
+					async_handler,
+					NULL);
+	if (err) {
+		LOG_ERR("Unable to write to LightDB State: %d", err);
+	}
+	return err;
+}
+
+int app_state_report_startup(void)
+{
+	char sbuf[APP_BOOT_PHASE_COUNT * sizeof("\"display_ready_ms\":4294967295,") + 2];
+	int err;
+
+	err = app_boot_to_json(sbuf, sizeof(sbuf));
+	if (err < 0) {
+		LOG_ERR("Unable to encode boot trace: %d", err);
+		return err;
+	}
+
+	err = golioth_lightdb_set_async(client,
+					APP_STATE_STARTUP_ENDP,
+					GOLIOTH_CONTENT_TYPE_JSON,
+					sbuf,
+					strlen(sbuf),
+					async_handler,
+					NULL);
+	if (err) {
+		LOG_ERR("Unable to write to LightDB State: %d", err);
+	}
+	return err;
+}
+
+#ifdef CONFIG_APP_REGMAP
+static void app_state_report_regmap(void)
+{
+	char sbuf[sizeof("{\"name\":\"\",\"generation\":65535,\"fields\":4294967295,"
+			 "\"registers\":65535,\"transactions\":4294967295}") +
+		  APP_REGMAP_NAME_LEN];
+	int err;
+
+	err = app_regmap_to_json(sbuf, sizeof(sbuf));
+	if (err < 0) {
+		LOG_ERR("Unable to encode register map status: %d", err);
+		return;
+	}
+
+	err = golioth_lightdb_set_async(client,
+					APP_STATE_REGMAP_STATUS_ENDP,
+					GOLIOTH_CONTENT_TYPE_JSON,
+					sbuf,
+					strlen(sbuf),
+					async_handler,
+					NULL);
+	if (err) {
+		LOG_ERR("Unable to write to LightDB State: %d", err);
+	}
+}
+
+/* The map is left in place, so it is applied again after every reconnect or reboot */
+static void app_state_regmap_handler(struct golioth_client *client, enum golioth_status status,
+				     const struct golioth_coap_rsp_code *coap_rsp_code,
+				     const char *path, const uint8_t *payload, size_t payload_size,
+				     void *arg)
+{
+	/* Only used from the Golioth client thread, and too large for its stack */
+	static struct app_state_regmap parsed;
+	static struct app_regmap_field fields[CONFIG_APP_REGMAP_MAX_FIELDS];
+	size_t i;
+	int ret;
+
+	if (status != GOLIOTH_OK) {
+		LOG_ERR("Failed to receive '%s' endpoint: %d", APP_STATE_REGMAP_ENDP, status);
+		return;
+	}
+
+	LOG_HEXDUMP_DBG(payload, payload_size, APP_STATE_REGMAP_ENDP);
+
+	memset(&parsed, 0, sizeof(parsed));
+
+	/* A path that was never written, or was deleted, reads as null: no map */
+	if ((payload_size != strlen("null")) || (memcmp(payload, "null", payload_size) != 0)) {
+		ret = json_obj_parse((char *)payload, payload_size, app_state_regmap_descr,
+				     ARRAY_SIZE(app_state_regmap_descr), &parsed);
+		if (ret < 0) {
+			LOG_ERR("Error parsing register map: %d", ret);
+			return;
+		}
+	}
+
+	for (i = 0; i < parsed.fields_len; i++) {
+		const struct app_state_regmap_field *field = &parsed.fields[i];
+
+		ret = field->type ? app_regmap_type_parse(field->type) : -EINVAL;
+		if ((ret < 0) || !field->name || (strlen(field->name) >= APP_REGMAP_NAME_LEN) ||
+		    (field->addr < 0) || (field->addr > UINT16_MAX) || (field->dec < 0) ||
+		    (field->dec > UINT8_MAX)) {
+			LOG_ERR("Invalid register map field %zu", i);
+			return;
+		}
+
+		strcpy(fields[i].name, field->name);
+		fields[i].addr = field->addr;
+		fields[i].type = ret;
+		fields[i].decimals = field->dec;
+		fields[i].swap = field->swap;
+	}
+
+	if (app_regmap_set(parsed.name, fields, i) == 0) {
+		app_state_report_regmap();
+	}
+}
+#endif /* CONFIG_APP_REGMAP */
+
 int app_state_observe(struct golioth_client *state_client)
 {
 	int err;
 
 	client = state_client;
 
+	IF_ENABLED(CONFIG_APP_REGMAP, (
+		err = golioth_lightdb_observe_async(client,
+						    APP_STATE_REGMAP_ENDP,
+						    GOLIOTH_CONTENT_TYPE_JSON,
+						    app_state_regmap_handler,
+						    NULL);
+		if (err) {
+			LOG_WRN("failed to observe lightdb path: %d", err);
+		}
+	));
+
 	err = golioth_lightdb_observe_async(client,
 					    APP_STATE_DESIRED_ENDP,
 					    GOLIOTH_CONTENT_TYPE_JSON,
@@ -30,8 +30,19 @@
 
 #define APP_STATE_DESIRED_ENDP "desired"
 #define APP_STATE_ACTUAL_ENDP  "state"
+#define APP_STATE_BUS_ENDP     "bus"
+#define APP_STATE_STARTUP_ENDP "startup"
+/* Register map of units polled with app_regmap.h, and what the device made of it */
+#define APP_STATE_REGMAP_ENDP	     "regmap"
+#define APP_STATE_REGMAP_STATUS_ENDP "regmap_status"
 
 int app_state_observe(struct golioth_client *state_client);
 int app_state_update_actual(void);
 
+/** Write Modbus bus statistics to the `APP_STATE_BUS_ENDP` path. */
+int app_state_report_bus(void);
+
+/** Write the boot-phase trace (see app_boot.h) to the `APP_STATE_STARTUP_ENDP` path. */
+int app_state_report_startup(void);
+
 #endif /* __APP_STATE_H__ */
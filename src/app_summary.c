@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#include "app_summary.h"
+
+/* Desired marker positions as a fraction of the samples seen */
+static const float marker_fraction[APP_SUMMARY_MARKERS] = {
+	0.0f, 0.25f, 0.5f, 0.725f, 0.95f, 0.97f, 0.99f, 0.995f, 1.0f,
+};
+
+void app_summary_reset(struct app_summary_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+}
+
+static float p2_parabolic(const struct app_summary_stats *s, int i, int d)
+{
+	float q = s->q[i];
+	float qp = s->q[i + 1];
+	float qm = s->q[i - 1];
+	int32_t n = s->n[i];
+	int32_t np = s->n[i + 1];
+	int32_t nm = s->n[i - 1];
+
+	return q + (float)d / (np - nm) *
+			   ((n - nm + d) * (qp - q) / (np - n) + (np - n - d) * (q - qm) / (n - nm));
+}
+
+static float p2_linear(const struct app_summary_stats *s, int i, int d)
+{
+	return s->q[i] + d * (s->q[i + d] - s->q[i]) / (s->n[i + d] - s->n[i]);
+}
+
+static void p2_add(struct app_summary_stats *s, float x)
+{
+	int k;
+
+	if (s->count <= APP_SUMMARY_MARKERS) {
+		/* Keep the first samples sorted; they become the initial markers */
+		for (k = s->count - 1; (k > 0) && (s->q[k - 1] > x); k--) {
+			s->q[k] = s->q[k - 1];
+		}
+		s->q[k] = x;
+		s->n[s->count - 1] = s->count - 1;
+		return;
+	}
+
+	/* Find the cell containing x, extending the extremes if needed */
+	if (x < s->q[0]) {
+		s->q[0] = x;
+		k = 0;
+	} else if (x >= s->q[APP_SUMMARY_MARKERS - 1]) {
+		s->q[APP_SUMMARY_MARKERS - 1] = x;
+		k = APP_SUMMARY_MARKERS - 2;
+	} else {
+		for (k = 0; x >= s->q[k + 1]; k++) {
+		}
+	}
+
+	for (int i = k + 1; i < APP_SUMMARY_MARKERS; i++) {
+		s->n[i]++;
+	}
+
+	/* Move the inner markers towards their desired positions */
+	for (int i = 1; i < APP_SUMMARY_MARKERS - 1; i++) {
+		float d = marker_fraction[i] * (s->count - 1) - s->n[i];
+
+		if (((d >= 1.0f) && (s->n[i + 1] - s->n[i] > 1)) ||
+		    ((d <= -1.0f) && (s->n[i - 1] - s->n[i] < -1))) {
+			int sign = (d > 0) ? 1 : -1;
+			float q = p2_parabolic(s, i, sign);
+
+			if ((s->q[i - 1] >= q) || (q >= s->q[i + 1])) {
+				q = p2_linear(s, i, sign);
+			}
+
+			s->q[i] = q;
+			s->n[i] += sign;
+		}
+	}
+}
+
+void app_summary_add(struct app_summary_stats *stats, float x)
+{
+	float delta;
+
+	stats->count++;
+
+	if ((stats->count == 1) || (x < stats->min)) {
+		stats->min = x;
+	}
+	if ((stats->count == 1) || (x > stats->max)) {
+		stats->max = x;
+	}
+
+	delta = x - stats->mean;
+	stats->mean += delta / stats->count;
+	stats->m2 += delta * (x - stats->mean);
+
+	p2_add(stats, x);
+}
+
+/* Interpolate the quantile p between the markers around its desired position. Once the
+ * markers have settled this is the height of the marker tracking p; before that, and while
+ * the first samples are still held sorted, it follows the markers actually available.
+ */
+static float marker_quantile(const struct app_summary_stats *stats, float p)
+{
+	int last = MIN(stats->count, APP_SUMMARY_MARKERS) - 1;
+	float pos = p * (stats->count - 1);
+	int i;
+
+	for (i = 0; (i < last - 1) && (stats->n[i + 1] < pos); i++) {
+	}
+
+	if ((i == last) || (stats->n[i + 1] == stats->n[i])) {
+		return stats->q[i];
+	}
+
+	return stats->q[i] + (stats->q[i + 1] - stats->q[i]) * (pos - stats->n[i]) /
+				     (stats->n[i + 1] - stats->n[i]);
+}
+
+void app_summary_get(const struct app_summary_stats *stats, struct app_summary_result *res)
+{
+	memset(res, 0, sizeof(*res));
+
+	res->count = stats->count;
+	if (stats->count == 0) {
+		return;
+	}
+
+	res->min = stats->min;
+	res->max = stats->max;
+	res->mean = stats->mean;
+	res->stddev = (stats->count > 1) ? sqrtf(stats->m2 / (stats->count - 1)) : 0.0f;
+
+	res->p50 = marker_quantile(stats, 0.5f);
+	res->p95 = marker_quantile(stats, 0.95f);
+	res->p99 = marker_quantile(stats, 0.99f);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_SUMMARY_H__
+#define __APP_SUMMARY_H__
+
+/** Fixed-size running statistics of a metric over a summary window.
+ *
+ * Count, minimum, maximum, mean and variance are kept with Welford's method.
+ * The median, 95th and 99th percentiles are estimated with the extended P²
+ * algorithm (Jain & Chlamtac, Raatikainen), which tracks nine markers instead
+ * of storing the samples, so memory does not depend on the window length.
+ * Quantiles are interpolated between markers, which is exact while the window
+ * holds no more than nine samples.
+ */
+
+#include <stdint.h>
+
+/* P² markers for p50, p95 and p99: the quantiles, their midpoints and the extremes */
+#define APP_SUMMARY_MARKERS 9
+
+struct app_summary_stats {
+	uint32_t count;
+	float mean;
+	/* Sum of squared differences from the mean */
+	float m2;
+	float min;
+	float max;
+	/* Marker heights and positions */
+	float q[APP_SUMMARY_MARKERS];
+	int32_t n[APP_SUMMARY_MARKERS];
+};
+
+struct app_summary_result {
+	uint32_t count;
+	float min;
+	float max;
+	float mean;
+	float stddev;
+	float p50;
+	float p95;
+	float p99;
+};
+
+void app_summary_reset(struct app_summary_stats *stats);
+void app_summary_add(struct app_summary_stats *stats, float x);
+
+/** Compute the summary of the samples added since the last reset. */
+void app_summary_get(const struct app_summary_stats *stats, struct app_summary_result *res);
+
+#endif /* __APP_SUMMARY_H__ */
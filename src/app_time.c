@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_DATE_TIME
+#include <date_time.h>
+#endif
+
+#include "app_time.h"
+
+int app_time_unix_offset_ms(int64_t *offset_ms)
+{
+#ifdef CONFIG_DATE_TIME
+	int64_t unix_ms;
+	int err;
+
+	err = date_time_now(&unix_ms);
+	if (err) {
+		return err;
+	}
+
+	*offset_ms = unix_ms - k_uptime_get();
+
+	return 0;
+#else
+	ARG_UNUSED(offset_ms);
+
+	return -ENOTSUP;
+#endif
+}
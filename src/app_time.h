@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_TIME_H__
+#define __APP_TIME_H__
+
+/** Convert between system uptime and wall clock time.
+ *
+ * Samples are timestamped with `k_uptime_get()` when they are taken, which is
+ * always available. When a wall clock source is available (the nRF91 modem
+ * date/time library), the offset returned here converts those uptime stamps to
+ * Unix time so the cloud can place buffered samples at the time they were
+ * measured rather than the time they were received.
+ */
+
+#include <stdint.h>
+
+/**
+ * Get the offset to add to an uptime value to obtain Unix time in milliseconds.
+ *
+ * @param offset_ms Offset in milliseconds
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if no wall clock source is built in
+ * @retval <0 if the wall clock is not (yet) valid
+ */
+int app_time_unix_offset_ms(int64_t *offset_ms);
+
+#endif /* __APP_TIME_H__ */
@@ -9,13 +9,57 @@
 
 #include <zephyr/data/json.h>
 
+struct app_state_unit {
+	int32_t id;
+	int32_t period_s;
+	bool regmap;
+};
+
+static const struct json_obj_descr app_state_unit_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct app_state_unit, id, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct app_state_unit, period_s, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct app_state_unit, regmap, JSON_TOK_TRUE)};
+
 struct app_state {
 	int32_t example_int0;
 	int32_t example_int1;
+	struct app_state_unit units[CONFIG_APP_BUS_MAX_UNITS];
+	size_t units_len;
 };
 
 static const struct json_obj_descr app_state_descr[] = {
 	JSON_OBJ_DESCR_PRIM(struct app_state, example_int0, JSON_TOK_NUMBER),
-	JSON_OBJ_DESCR_PRIM(struct app_state, example_int1, JSON_TOK_NUMBER)};
+	JSON_OBJ_DESCR_PRIM(struct app_state, example_int1, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_OBJ_ARRAY(struct app_state, units, CONFIG_APP_BUS_MAX_UNITS, units_len,
+				 app_state_unit_descr, ARRAY_SIZE(app_state_unit_descr))};
+
+#ifdef CONFIG_APP_REGMAP
+struct app_state_regmap_field {
+	const char *name;
+	int32_t addr;
+	const char *type;
+	int32_t dec;
+	bool swap;
+};
+
+static const struct json_obj_descr app_state_regmap_field_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct app_state_regmap_field, name, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct app_state_regmap_field, addr, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct app_state_regmap_field, type, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct app_state_regmap_field, dec, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_PRIM(struct app_state_regmap_field, swap, JSON_TOK_TRUE)};
+
+struct app_state_regmap {
+	const char *name;
+	struct app_state_regmap_field fields[CONFIG_APP_REGMAP_MAX_FIELDS];
+	size_t fields_len;
+};
+
+static const struct json_obj_descr app_state_regmap_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct app_state_regmap, name, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_OBJ_ARRAY(struct app_state_regmap, fields, CONFIG_APP_REGMAP_MAX_FIELDS,
+				 fields_len, app_state_regmap_field_descr,
+				 ARRAY_SIZE(app_state_regmap_field_descr))};
+#endif /* CONFIG_APP_REGMAP */
 
 #endif
@@ -9,6 +9,11 @@
 LOG_MODULE_REGISTER(golioth_modbus_vibration_monitor, LOG_LEVEL_DBG);
 
 #include <app_version.h>
+#include "app_acq.h"
+#include "app_bench.h"
+#include "app_boot.h"
+#include "app_bus.h"
+#include "app_log.h"
 #include "app_rpc.h"
 #include "app_settings.h"
 #include "app_state.h"
@@ -24,12 +29,9 @@ LOG_MODULE_REGISTER(golioth_modbus_vibration_monitor, LOG_LEVEL_DBG);
 #endif
 #ifdef CONFIG_LIB_OSTENTUS
 #include <libostentus.h>
-#include <libostentus_regmap.h>
+#include "app_display.h"
 static const struct device *o_dev = DEVICE_DT_GET_ANY(golioth_ostentus);
 #endif
-#ifdef CONFIG_ALUDEL_BATTERY_MONITOR
-#include <battery_monitor.h>
-#endif
 
 #include <zephyr/drivers/gpio.h>
 
@@ -37,14 +39,15 @@ static const struct device *o_dev = DEVICE_DT_GET_ANY(golioth_ostentus);
 #include <modem/modem_info.h>
 #endif
 
+#ifdef CONFIG_APP_BENCHMARK
+#include <posix_board_if.h>
+#endif
+
 /* Current firmware version; update in VERSION */
 static const char *_current_version =
 	STRINGIFY(APP_VERSION_MAJOR) "." STRINGIFY(APP_VERSION_MINOR) "." STRINGIFY(APP_PATCHLEVEL);
 
 static struct golioth_client *client;
-K_SEM_DEFINE(connected, 0, 1);
-
-static k_tid_t _system_thread = 0;
 
 #if DT_NODE_EXISTS(DT_ALIAS(golioth_led))
 static const struct gpio_dt_spec golioth_led = GPIO_DT_SPEC_GET(DT_ALIAS(golioth_led), gpios);
@@ -57,7 +60,8 @@ void golioth_connection_led_set(uint8_t state);
 
 void wake_system_thread(void)
 {
-	k_wakeup(_system_thread);
+	/* Polling runs on the acquisition thread, poll every unit right away */
+	app_acq_poll_all();
 }
 
 static void on_client_event(struct golioth_client *client, enum golioth_client_event event,
@@ -66,8 +70,9 @@ static void on_client_event(struct golioth_client *client, enum golioth_client_e
 	bool is_connected = (event == GOLIOTH_CLIENT_EVENT_CONNECTED);
 
 	if (is_connected) {
-		k_sem_give(&connected);
+		app_boot_mark(APP_BOOT_FIRST_CONNECT);
 		golioth_connection_led_set(1);
+		app_sensors_client_connected();
 	}
 	LOG_INF("Golioth client %s", is_connected ? "connected" : "disconnected");
 }
@@ -80,11 +85,14 @@ static void start_golioth_client(void)
 	/* Create and start a Golioth Client */
 	client = golioth_client_create(client_config);
 
+	/* Creating the client enables the Golioth log backend */
+	app_log_init();
+
 	/* Register Golioth on_connect callback */
 	golioth_client_register_event_callback(client, on_client_event, NULL);
 
 	/* Initialize DFU components */
-	golioth_fw_update_init(client, _current_version);
+	IF_ENABLED(CONFIG_GOLIOTH_FW_UPDATE, (golioth_fw_update_init(client, _current_version);));
 
 	/*** Call Golioth APIs for other services in dedicated app files ***/
 
@@ -109,6 +117,7 @@ static void lte_handler(const struct lte_lc_evt *const evt)
 
 		if ((evt->nw_reg_status == LTE_LC_NW_REG_REGISTERED_HOME) ||
 		    (evt->nw_reg_status == LTE_LC_NW_REG_REGISTERED_ROAMING)) {
+			app_boot_mark(APP_BOOT_NET_READY);
 
 			/* Change the state of the Internet LED on Ostentus */
 			IF_ENABLED(CONFIG_LIB_OSTENTUS, (ostentus_led_internet_set(o_dev, 1);));
@@ -121,10 +130,28 @@ static void lte_handler(const struct lte_lc_evt *const evt)
 	}
 }
 
+#else
+
+/* Wi-Fi and DHCP may take a while, so the network is brought up beside sampling */
+static void connect_thread_fn(void *p1, void *p2, void *p3)
+{
+	/* Run WiFi/DHCP if necessary */
+	if (IS_ENABLED(CONFIG_GOLIOTH_SAMPLE_COMMON)) {
+		net_connect();
+	}
+	app_boot_mark(APP_BOOT_NET_READY);
+
+	/* Start Golioth client */
+	start_golioth_client();
+}
+
+K_THREAD_DEFINE(connect_thread, CONFIG_MAIN_STACK_SIZE, connect_thread_fn, NULL, NULL, NULL,
+		CONFIG_MAIN_THREAD_PRIORITY, 0, K_TICKS_FOREVER);
+
 #endif /* CONFIG_SOC_SERIES_NRF91X */
 
 #ifdef CONFIG_MODEM_INFO
-static void log_modem_firmware_version(void)
+static void log_modem_firmware_version(struct k_work *work)
 {
 	char sbuf[128];
 
@@ -139,6 +166,8 @@ static void log_modem_firmware_version(void)
 	modem_info_string_get(MODEM_INFO_FW_VERSION, sbuf, sizeof(sbuf));
 	LOG_INF("Modem firmware version: %s", sbuf);
 }
+
+static K_WORK_DEFINE(modem_info_work, log_modem_firmware_version);
 #endif
 
 void button_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
@@ -147,7 +176,7 @@ void button_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t
 	/* This function is an Interrupt Service Routine. Do not call functions that
 	 * use other threads, or perform long-running operations here
 	 */
-	k_wakeup(_system_thread);
+	app_acq_poll_all();
 }
 
 /* Set (unset) LED indicators for active Golioth connection */
@@ -168,38 +197,29 @@ int main(void)
 {
 	int err;
 
+	app_boot_mark(APP_BOOT_MAIN);
+
 	/* Workaround for https://github.com/golioth/golioth-firmware-sdk/issues/413 */
 	log_filter_set(NULL, 0, log_source_id_get("golioth_coap_client_zephyr"), LOG_LEVEL_ERR);
 
 	LOG_DBG("Started Modbus Vibration Monitor app");
 
 	LOG_INF("Firmware version: %s", _current_version);
-	IF_ENABLED(CONFIG_MODEM_INFO, (log_modem_firmware_version();));
-
-	IF_ENABLED(CONFIG_LIB_OSTENTUS, (
-		/* Reset Ostentus and pause for reboot */
-		ostentus_reset(o_dev);
-		k_msleep(300);
-
-		/* Read firmware version from faceplate */
-		char *o_version = (char *)calloc(32, sizeof(char));
-
-		ostentus_version_get(o_dev, o_version, 32);
-		LOG_INF("Ostentus reports firmware version: %s", o_version);
-		free(o_version);
-
-		/* Update Ostentus LEDS using bitmask (Power On and Battery) */
-		ostentus_led_bitmask(o_dev, LED_POW | LED_BAT);
 
-		/* Show Golioth Logo on Ostentus ePaper screen */
-		ostentus_show_splash(o_dev);
-	));
+	/* Initialize sensors and start the Modbus acquisition thread */
+	app_sensors_init();
 
-	/* Get system thread id so loop delay change event can wake main */
-	_system_thread = k_current_get();
+#ifdef CONFIG_APP_BENCHMARK
+	/* Run against the simulated sensor without connecting, then exit */
+	err = app_bench_run();
+	posix_exit(err ? 1 : 0);
+#endif /* CONFIG_APP_BENCHMARK */
 
-	/* Initialize sensors */
-	app_sensors_init();
+	/* Sample with the settings and units last received from Golioth until it is
+	 * reached, samples are buffered until the client connects
+	 */
+	app_settings_load();
+	app_bus_load_units();
 
 #if DT_NODE_EXISTS(DT_ALIAS(golioth_led))
 	/* Initialize Golioth logo LED */
@@ -218,19 +238,18 @@ int main(void)
 	lte_lc_connect_async(lte_handler);
 
 #else
-	/* If nRF9160 is not used, start the Golioth Client and block until connected */
-
-	/* Run WiFi/DHCP if necessary */
-	if (IS_ENABLED(CONFIG_GOLIOTH_SAMPLE_COMMON)) {
-		net_connect();
-	}
+	/* If nRF9160 is not used, connect and start the Golioth Client in the background */
+	k_thread_start(connect_thread);
+#endif /* CONFIG_SOC_SERIES_NRF91X */
 
-	/* Start Golioth client */
-	start_golioth_client();
+	/* Steps the acquisition path does not depend on run beside it */
+	app_boot_init();
+	IF_ENABLED(CONFIG_MODEM_INFO, (app_boot_submit(&modem_info_work);));
+	IF_ENABLED(CONFIG_LIB_OSTENTUS, (app_display_init(_current_version);));
 
-	/* Block until connected to Golioth */
-	k_sem_take(&connected, K_FOREVER);
-#endif /* CONFIG_SOC_SERIES_NRF91X */
+	/* Poll results arrive from the acquisition thread, which keeps the schedule */
+	app_acq_polling_set(true);
+	app_boot_mark(APP_BOOT_ACQ_READY);
 
 	/* Set up user button */
 	err = gpio_pin_configure_dt(&user_btn, GPIO_INPUT);
@@ -250,60 +269,7 @@ int main(void)
 	gpio_init_callback(&button_cb_data, button_pressed, BIT(user_btn.pin));
 	gpio_add_callback(user_btn.port, &button_cb_data);
 
-	IF_ENABLED(CONFIG_LIB_OSTENTUS,(
-		/* Set up a slideshow on Ostentus
-		 *  - add up to 256 slides
-		 *  - use the enum in app_sensors.h to add new keys
-		 *  - values are updated using these keys (see app_sensors.c)
-		 */
-		ostentus_slide_add(o_dev, TEMP_F, LABEL_TEMP, strlen(LABEL_TEMP));
-		ostentus_slide_add(o_dev, TEMP_C, LABEL_TEMP, strlen(LABEL_TEMP));
-		ostentus_slide_add(o_dev, Z_VEL_RMS_IN, LABEL_Z_VEL_RMS, strlen(LABEL_Z_VEL_RMS));
-		ostentus_slide_add(o_dev, Z_VEL_RMS_MM, LABEL_Z_VEL_RMS, strlen(LABEL_Z_VEL_RMS));
-		ostentus_slide_add(o_dev, X_VEL_RMS_IN, LABEL_X_VEL_RMS, strlen(LABEL_X_VEL_RMS));
-		ostentus_slide_add(o_dev, X_VEL_RMS_MM, LABEL_X_VEL_RMS, strlen(LABEL_X_VEL_RMS));
-		ostentus_slide_add(o_dev, Z_ACC_PEAK, LABEL_Z_ACC_PEAK, strlen(LABEL_Z_ACC_PEAK));
-		ostentus_slide_add(o_dev, X_ACC_PEAK, LABEL_X_ACC_PEAK, strlen(LABEL_X_ACC_PEAK));
-		ostentus_slide_add(o_dev, Z_VEL_FREQ, LABEL_Z_VEL_FREQ, strlen(LABEL_Z_VEL_FREQ));
-		ostentus_slide_add(o_dev, X_VEL_FREQ, LABEL_X_VEL_FREQ, strlen(LABEL_X_VEL_FREQ));
-		ostentus_slide_add(o_dev, Z_ACC_RMS, LABEL_Z_ACC_RMS, strlen(LABEL_Z_ACC_RMS));
-		ostentus_slide_add(o_dev, X_ACC_RMS, LABEL_X_ACC_RMS, strlen(LABEL_X_ACC_RMS));
-		ostentus_slide_add(o_dev, Z_ACC_KURT, LABEL_Z_ACC_KURT, strlen(LABEL_Z_ACC_KURT));
-		ostentus_slide_add(o_dev, X_ACC_KURT, LABEL_X_ACC_KURT, strlen(LABEL_X_ACC_KURT));
-		ostentus_slide_add(o_dev, Z_ACC_CF, LABEL_Z_ACC_CF, strlen(LABEL_Z_ACC_CF));
-		ostentus_slide_add(o_dev, X_ACC_CF, LABEL_X_ACC_CF, strlen(LABEL_X_ACC_CF));
-		ostentus_slide_add(o_dev, Z_VEL_PEAK_IN, LABEL_Z_VEL_PEAK, strlen(LABEL_Z_VEL_PEAK));
-		ostentus_slide_add(o_dev, Z_VEL_PEAK_MM, LABEL_Z_VEL_PEAK, strlen(LABEL_Z_VEL_PEAK));
-		ostentus_slide_add(o_dev, X_VEL_PEAK_IN, LABEL_X_VEL_PEAK, strlen(LABEL_X_VEL_PEAK));
-		ostentus_slide_add(o_dev, X_VEL_PEAK_MM, LABEL_X_VEL_PEAK, strlen(LABEL_X_VEL_PEAK));
-		ostentus_slide_add(o_dev, Z_ACC_RMS_HF, LABEL_Z_ACC_RMS_HF, strlen(LABEL_Z_ACC_RMS_HF));
-		ostentus_slide_add(o_dev, X_ACC_RMS_HF, LABEL_X_ACC_RMS_HF, strlen(LABEL_X_ACC_RMS_HF));
-		IF_ENABLED(CONFIG_ALUDEL_BATTERY_MONITOR, (
-			ostentus_slide_add(o_dev,
-					   BATTERY_V,
-					   LABEL_BATTERY,
-					   strlen(LABEL_BATTERY));
-			ostentus_slide_add(o_dev,
-					   BATTERY_LVL,
-					   LABEL_BATTERY,
-					   strlen(LABEL_BATTERY));
-		));
-		ostentus_slide_add(o_dev, FIRMWARE, LABEL_FIRMWARE, strlen(LABEL_FIRMWARE));
-
-		/* Set the title of the Ostentus summary slide (optional) */
-		ostentus_summary_title(o_dev, SUMMARY_TITLE, strlen(SUMMARY_TITLE));
-
-		/* Update the Firmware slide with the firmware version */
-		ostentus_slide_set(o_dev, FIRMWARE, (char *)_current_version,
-			  strlen(_current_version));
-
-		/* Start Ostentus slideshow with 30 second delay between slides */
-		ostentus_slideshow(o_dev, 30000);
-	));
-
 	while (true) {
 		app_sensors_read_and_stream();
-
-		k_sleep(K_SECONDS(get_loop_delay_s()));
 	}
 }
@@ -4,177 +4,329 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <stdlib.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/modbus/modbus.h>
-#include <zephyr/drivers/sensor.h>
 
+#include "app_fixed.h"
+#include "app_log.h"
 #include "qm30vt2.h"
 
 LOG_MODULE_REGISTER(qm30vt2, LOG_LEVEL_DBG);
 
-int qm30vt2_reg_to_value(uint8_t reg_type, uint16_t reg_val, struct sensor_value *val)
+static const char *const quantity_unit[QM30VT2_QTY_COUNT] = {
+	[QM30VT2_QTY_TEMP_C] = "C",
+	[QM30VT2_QTY_TEMP_F] = "F",
+	[QM30VT2_QTY_ACC_G] = "G",
+	[QM30VT2_QTY_VEL_IN] = "in/sec",
+	[QM30VT2_QTY_VEL_MM] = "mm/sec",
+	[QM30VT2_QTY_FREQ_HZ] = "Hz",
+	[QM30VT2_QTY_RATIO] = "",
+};
+
+struct qm30vt2_metric {
+	/* Offset of the value in struct qm30vt2_measurement */
+	uint16_t offset;
+	/* Index in the alias register block */
+	uint8_t reg;
+	uint8_t qty;
+	uint8_t decimals;
+	bool is_signed;
+	/* Value in the unit of qty = register value ÷ div, with div = 10^decimals */
+	uint16_t div;
+	/* Key in the measurement log */
+	const char *key;
+	const char *desc;
+};
+
+/* clang-format off */
+#define QM30VT2_POW10(dec)                                                                         \
+	((dec) == 4 ? 10000 : (dec) == 3 ? 1000 : (dec) == 2 ? 100 : (dec) == 1 ? 10 : 1)
+/* clang-format on */
+
+#define QM30VT2_X_METRIC(name, NAME, idx, dec, sgn, q, label, desc_str, ...)                       \
+	{                                                                                          \
+		.offset = offsetof(struct qm30vt2_measurement, name),                              \
+		.reg = (idx),                                                                      \
+		.qty = QM30VT2_QTY_##q,                                                            \
+		.decimals = (dec),                                                                 \
+		.is_signed = (sgn),                                                                \
+		.div = QM30VT2_POW10(dec),                                                         \
+		.key = #name,                                                                      \
+		.desc = (desc_str),                                                                \
+	},
+
+static const struct qm30vt2_metric metrics[] = {QM30VT2_METRICS(QM30VT2_X_METRIC)};
+
+/* "name=value " for every metric, the last separator holds the terminator */
+#define QM30VT2_X_LOG_LEN(name, ...) +sizeof(#name) + APP_FIXED_STR_LEN
+#define QM30VT2_LOG_LINE_LEN         (0 QM30VT2_METRICS(QM30VT2_X_LOG_LEN))
+
+#ifdef CONFIG_APP_QM30VT2_EXT
+#define EXT_REGS_MAX CONFIG_APP_QM30VT2_EXT_REGS_MAX
+
+/* CONFIG_APP_QM30VT2_EXT_REGS as parsed by qm30vt2_init(), in configuration order */
+static uint16_t ext_addr[EXT_REGS_MAX];
+static size_t ext_count;
+#else
+#define EXT_REGS_MAX 0
+#endif
+
+/* Mask of the last read plan, which is logged when it changes */
+static uint32_t planned_mask;
+
+static inline int32_t *metric_value(const struct qm30vt2_metric *metric,
+				    const struct qm30vt2_measurement *meas)
+{
+	return (int32_t *)((uint8_t *)meas + metric->offset);
+}
+
+uint16_t qm30vt2_reg_span(uint32_t mask, uint16_t *first)
+{
+	uint16_t lo = QM30VT2_ALIAS_SIZE;
+	uint16_t hi = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(metrics); i++) {
+		if (mask & BIT(i)) {
+			lo = MIN(lo, metrics[i].reg);
+			hi = MAX(hi, metrics[i].reg);
+		}
+	}
+
+	if (lo > hi) {
+		return 0;
+	}
+
+	*first = lo;
+
+	return hi - lo + 1;
+}
+
+int qm30vt2_read_plan(const struct qm30vt2_reg_req *reqs, size_t count, uint16_t gap_max,
+		      struct qm30vt2_xfer *xfers, size_t max_xfers)
+{
+	struct qm30vt2_xfer *xfer = NULL;
+	size_t n = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		int addr = reqs[i].addr;
+
+		if (xfer && (addr < xfer->addr + xfer->count)) {
+			/* Already read, e.g. an extended register inside the alias block */
+			continue;
+		}
+
+		if (xfer && (addr - (xfer->addr + xfer->count) <= gap_max) &&
+		    (addr - xfer->addr < QM30VT2_READ_MAX_REGS)) {
+			xfer->count = addr - xfer->addr + 1;
+			continue;
+		}
+
+		if (n == max_xfers) {
+			return -ENOMEM;
+		}
+
+		xfer = &xfers[n++];
+		xfer->addr = addr;
+		xfer->count = 1;
+	}
+
+	return n;
+}
+
+int qm30vt2_read_planned(const int iface, uint8_t unit_id, const struct qm30vt2_xfer *xfers,
+			 size_t xfer_count, const struct qm30vt2_reg_req *reqs, size_t count)
+{
+	uint16_t buf[QM30VT2_READ_MAX_REGS];
+	size_t r = 0;
+	int err;
+
+	for (size_t i = 0; i < xfer_count; i++) {
+		const struct qm30vt2_xfer *xfer = &xfers[i];
+
+		err = modbus_read_holding_regs(iface, unit_id, xfer->addr, buf, xfer->count);
+		if (err != 0) {
+			APP_LOG_ERR_RL("Modbus FC03 of %u registers at %u failed with %d",
+				       xfer->count, xfer->addr, err);
+			return err;
+		}
+
+		/* Requests are in address order, so each transaction serves the next few */
+		for (; (r < count) && (reqs[r].addr < xfer->addr + xfer->count); r++) {
+			*reqs[r].dst = buf[reqs[r].addr - xfer->addr];
+		}
+	}
+
+	return 0;
+}
+
+int qm30vt2_read_regs(const int iface, uint8_t unit_id, uint16_t *holding_reg, uint32_t mask,
+		      struct qm30vt2_measurement *meas)
 {
-	uint16_t scaling_factor;
-	bool reg_val_is_signed;
-
-	switch (reg_type) {
-	/* value = register value ÷ 10000 */
-	case QM30VT2_Z_VEL_RMS_IN:
-	case QM30VT2_X_VEL_RMS_IN:
-	case QM30VT2_Z_VEL_PEAK_IN:
-	case QM30VT2_X_VEL_PEAK_IN:
-		scaling_factor = 10000;
-		reg_val_is_signed = false;
-		break;
-	/* value = register value ÷ 1000 */
-	case QM30VT2_Z_VEL_RMS_MM:
-	case QM30VT2_X_VEL_RMS_MM:
-	case QM30VT2_Z_ACC_PEAK:
-	case QM30VT2_X_ACC_PEAK:
-	case QM30VT2_Z_ACC_RMS:
-	case QM30VT2_X_ACC_RMS:
-	case QM30VT2_Z_ACC_KURT:
-	case QM30VT2_X_ACC_KURT:
-	case QM30VT2_Z_ACC_CF:
-	case QM30VT2_X_ACC_CF:
-	case QM30VT2_Z_VEL_PEAK_MM:
-	case QM30VT2_X_VEL_PEAK_MM:
-	case QM30VT2_Z_ACC_RMS_HF:
-	case QM30VT2_X_ACC_RMS_HF:
-		scaling_factor = 1000;
-		reg_val_is_signed = false;
-		break;
-	/* value = register value ÷ 100 */
-	case QM30VT2_TEMP_F:
-	case QM30VT2_TEMP_C:
-		scaling_factor = 100;
-		reg_val_is_signed = true; /* ONLY temp values are signed */
-		break;
-	/* value = register value ÷ 10 */
-	case QM30VT2_Z_VEL_FREQ:
-	case QM30VT2_X_VEL_FREQ:
-		scaling_factor = 10;
-		reg_val_is_signed = false;
-		break;
-	default:
-		LOG_ERR("Invalid Modbus holding register alias index");
+	struct qm30vt2_reg_req reqs[QM30VT2_ALIAS_SIZE + EXT_REGS_MAX];
+	struct qm30vt2_xfer xfers[ARRAY_SIZE(reqs)];
+	uint32_t alias_regs = 0;
+	size_t count = 0;
+	int n;
+
+	for (size_t i = 0; i < ARRAY_SIZE(metrics); i++) {
+		if (mask & BIT(i)) {
+			alias_regs |= BIT(metrics[i].reg);
+		}
+	}
+
+	if (alias_regs == 0) {
 		return -EINVAL;
 	}
 
-	if (reg_val_is_signed) {
-		val->val1 = ((int16_t)reg_val / scaling_factor);
-		val->val2 = ((int16_t)reg_val % scaling_factor) * (1000000 / scaling_factor);
-	} else {
-		val->val1 = (reg_val / scaling_factor);
-		val->val2 = (reg_val % scaling_factor) * (1000000 / scaling_factor);
+	for (size_t reg = 0; reg < QM30VT2_ALIAS_SIZE; reg++) {
+		if (alias_regs & BIT(reg)) {
+			reqs[count].addr = QM30VT2_ALIAS_BASE_ADDR + reg;
+			reqs[count].dst = &holding_reg[reg];
+			count++;
+		}
 	}
 
+#ifdef CONFIG_APP_QM30VT2_EXT
+	/* Insert extended registers in address order */
+	for (size_t i = 0; i < ext_count; i++) {
+		size_t j = count++;
+
+		for (; (j > 0) && (reqs[j - 1].addr > ext_addr[i]); j--) {
+			reqs[j] = reqs[j - 1];
+		}
+		reqs[j].addr = ext_addr[i];
+		reqs[j].dst = &meas->ext_reg[i];
+	}
+#endif
+
+	n = qm30vt2_read_plan(reqs, count, CONFIG_APP_QM30VT2_READ_GAP_MAX, xfers,
+			      ARRAY_SIZE(xfers));
+	if (n < 0) {
+		return n;
+	}
+
+	if (mask != planned_mask) {
+		planned_mask = mask;
+		LOG_INF("Reading %zu registers in %d transactions", count, n);
+	}
+
+	return qm30vt2_read_planned(iface, unit_id, xfers, n, reqs, count);
+}
+
+size_t qm30vt2_ext_count(void)
+{
+	COND_CODE_1(CONFIG_APP_QM30VT2_EXT, (return ext_count;), (return 0;));
+}
+
+int qm30vt2_init(void)
+{
+#ifdef CONFIG_APP_QM30VT2_EXT
+	const char *str = CONFIG_APP_QM30VT2_EXT_REGS;
+	char *end;
+
+	while (true) {
+		unsigned long addr;
+
+		while ((*str == ' ') || (*str == ',')) {
+			str++;
+		}
+		if (*str == '\0') {
+			break;
+		}
+
+		addr = strtoul(str, &end, 0);
+		if ((end == str) || (addr > UINT16_MAX) || (ext_count == ARRAY_SIZE(ext_addr))) {
+			LOG_ERR("Invalid extended registers from \"%s\", none are read", str);
+			ext_count = 0;
+			return -EINVAL;
+		}
+
+		ext_addr[ext_count++] = addr;
+		str = end;
+	}
+
+	LOG_INF("Reading %zu extended registers", ext_count);
+#endif
+
 	return 0;
 }
 
-int qm30vt2_read_data(const int iface, uint8_t unit_id, struct qm30vt2_measurement *meas)
+int qm30vt2_decode(const uint16_t *holding_reg, struct qm30vt2_measurement *meas, uint32_t mask)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(metrics); i++) {
+		const struct qm30vt2_metric *metric = &metrics[i];
+		int32_t *val = metric_value(metric, meas);
+
+		if (!(mask & BIT(i))) {
+			*val = 0;
+			continue;
+		}
+
+		/* ONLY temp values are signed */
+		if (metric->is_signed) {
+			*val = (int16_t)holding_reg[metric->reg];
+		} else {
+			*val = holding_reg[metric->reg];
+		}
+	}
+
+	return 0;
+}
+
+int qm30vt2_read_data(const int iface, uint8_t unit_id, struct qm30vt2_measurement *meas,
+		      uint32_t mask)
 {
 	int err;
 	uint16_t holding_reg[QM30VT2_ALIAS_SIZE] = {0};
 
-	err = modbus_read_holding_regs(iface, unit_id, QM30VT2_ALIAS_BASE_ADDR, holding_reg,
-				       ARRAY_SIZE(holding_reg));
-	if (err != 0) {
-		LOG_ERR("Modbus FC03 failed with %d", err);
+	err = qm30vt2_read_regs(iface, unit_id, holding_reg, mask, meas);
+	if (err) {
 		return err;
 	}
 
-	/* LOG_HEXDUMP_INF(holding_reg, sizeof(holding_reg), "WR|RD holding register:"); */
-
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_VEL_RMS_IN, holding_reg[QM30VT2_Z_VEL_RMS_IN],
-				    &meas->z_vel_rms_in);
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_VEL_RMS_MM, holding_reg[QM30VT2_Z_VEL_RMS_MM],
-				    &meas->z_vel_rms_mm);
-	err |= qm30vt2_reg_to_value(QM30VT2_TEMP_F, holding_reg[QM30VT2_TEMP_F], &meas->temp_f);
-	err |= qm30vt2_reg_to_value(QM30VT2_TEMP_C, holding_reg[QM30VT2_TEMP_C], &meas->temp_c);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_VEL_RMS_IN, holding_reg[QM30VT2_X_VEL_RMS_IN],
-				    &meas->x_vel_rms_in);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_VEL_RMS_MM, holding_reg[QM30VT2_X_VEL_RMS_MM],
-				    &meas->x_vel_rms_mm);
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_ACC_PEAK, holding_reg[QM30VT2_Z_ACC_PEAK],
-				    &meas->z_acc_peak);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_ACC_PEAK, holding_reg[QM30VT2_X_ACC_PEAK],
-				    &meas->x_acc_peak);
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_VEL_FREQ, holding_reg[QM30VT2_Z_VEL_FREQ],
-				    &meas->z_vel_peak_freq);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_VEL_FREQ, holding_reg[QM30VT2_X_VEL_FREQ],
-				    &meas->x_vel_peak_freq);
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_ACC_RMS, holding_reg[QM30VT2_Z_ACC_RMS],
-				    &meas->z_acc_rms);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_ACC_RMS, holding_reg[QM30VT2_X_ACC_RMS],
-				    &meas->x_acc_rms);
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_ACC_KURT, holding_reg[QM30VT2_Z_ACC_KURT],
-				    &meas->z_acc_kurt);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_ACC_KURT, holding_reg[QM30VT2_X_ACC_KURT],
-				    &meas->x_acc_kurt);
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_ACC_CF, holding_reg[QM30VT2_Z_ACC_CF],
-				    &meas->z_acc_cf);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_ACC_CF, holding_reg[QM30VT2_X_ACC_CF],
-				    &meas->x_acc_cf);
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_VEL_PEAK_IN, holding_reg[QM30VT2_Z_VEL_PEAK_IN],
-				    &meas->z_vel_peak_in);
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_VEL_PEAK_MM, holding_reg[QM30VT2_Z_VEL_PEAK_MM],
-				    &meas->z_vel_peak_mm);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_VEL_PEAK_IN, holding_reg[QM30VT2_X_VEL_PEAK_IN],
-				    &meas->x_vel_peak_in);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_VEL_PEAK_MM, holding_reg[QM30VT2_X_VEL_PEAK_MM],
-				    &meas->x_vel_peak_mm);
-	err |= qm30vt2_reg_to_value(QM30VT2_Z_ACC_RMS_HF, holding_reg[QM30VT2_Z_ACC_RMS_HF],
-				    &meas->z_acc_rms_hf);
-	err |= qm30vt2_reg_to_value(QM30VT2_X_ACC_RMS_HF, holding_reg[QM30VT2_X_ACC_RMS_HF],
-				    &meas->x_acc_rms_hf);
-
-	return err;
+	return qm30vt2_decode(holding_reg, meas, mask);
+}
+
+int qm30vt2_metric_format(char *buf, size_t len, const struct qm30vt2_measurement *meas,
+			  size_t idx)
+{
+	const struct qm30vt2_metric *metric = &metrics[idx];
+	const char *unit = quantity_unit[metric->qty];
+	char num[APP_FIXED_STR_LEN];
+
+	app_fixed_format(num, sizeof(num), *metric_value(metric, meas), metric->decimals);
+
+	return snprintk(buf, len, "%s%s%s", num, unit[0] ? " " : "", unit);
 }
 
-void qm30vt2_log_measurements(struct qm30vt2_measurement *meas)
+float qm30vt2_metric_float(const struct qm30vt2_measurement *meas, size_t idx)
 {
-	/* Log Temperature measurements */
-	LOG_DBG("QM30VT2: Temperature=%.2f °F", sensor_value_to_double(&meas->temp_f));
-	LOG_DBG("QM30VT2: Temperature=%.2f °C", sensor_value_to_double(&meas->temp_c));
-
-	/* Log Z-Axis measurements */
-	LOG_DBG("QM30VT2: Z-Axis RMS Velocity=%.4f in/sec",
-		sensor_value_to_double(&meas->z_vel_rms_in));
-	LOG_DBG("QM30VT2: Z-Axis Peak Velocity=%.4f in/sec",
-		sensor_value_to_double(&meas->z_vel_peak_in));
-	LOG_DBG("QM30VT2: Z-Axis RMS Velocity=%.3f mm/sec",
-		sensor_value_to_double(&meas->z_vel_rms_mm));
-	LOG_DBG("QM30VT2: Z-Axis Peak Velocity=%.3f mm/sec",
-		sensor_value_to_double(&meas->z_vel_peak_mm));
-	LOG_DBG("QM30VT2: Z-Axis Peak Velocity Component Frequency=%.1f Hz",
-		sensor_value_to_double(&meas->z_vel_peak_freq));
-	LOG_DBG("QM30VT2: Z-Axis RMS Acceleration=%.3f G",
-		sensor_value_to_double(&meas->z_acc_rms));
-	LOG_DBG("QM30VT2: Z-Axis Peak Acceleration=%.3f G",
-		sensor_value_to_double(&meas->z_acc_peak));
-	LOG_DBG("QM30VT2: Z-Axis Crest Factor=%.3f", sensor_value_to_double(&meas->z_acc_cf));
-	LOG_DBG("QM30VT2: Z-Axis Kurtosis=%.3f", sensor_value_to_double(&meas->z_acc_kurt));
-	LOG_DBG("QM30VT2: Z-Axis High-Frequency RMS Acceleration=%.3f G",
-		sensor_value_to_double(&meas->z_acc_rms_hf));
-
-	/* Log X-Axis measurements */
-	LOG_DBG("QM30VT2: X-Axis RMS Velocity=%.4f in/sec",
-		sensor_value_to_double(&meas->x_vel_rms_in));
-	LOG_DBG("QM30VT2: X-Axis Peak Velocity=%.4f in/sec",
-		sensor_value_to_double(&meas->x_vel_peak_in));
-	LOG_DBG("QM30VT2: X-Axis RMS Velocity=%.3f mm/sec",
-		sensor_value_to_double(&meas->x_vel_rms_mm));
-	LOG_DBG("QM30VT2: X-Axis Peak Velocity=%.3f mm/sec",
-		sensor_value_to_double(&meas->x_vel_peak_mm));
-	LOG_DBG("QM30VT2: X-Axis Peak Velocity Component Frequency=%.1f Hz",
-		sensor_value_to_double(&meas->x_vel_peak_freq));
-	LOG_DBG("QM30VT2: X-Axis RMS Acceleration=%.3f G",
-		sensor_value_to_double(&meas->x_acc_rms));
-	LOG_DBG("QM30VT2: X-Axis Peak Acceleration=%.3f G",
-		sensor_value_to_double(&meas->x_acc_peak));
-	LOG_DBG("QM30VT2: X-Axis Crest Factor=%.3f", sensor_value_to_double(&meas->x_acc_cf));
-	LOG_DBG("QM30VT2: X-Axis Kurtosis=%.3f", sensor_value_to_double(&meas->x_acc_kurt));
-	LOG_DBG("QM30VT2: X-Axis High-Frequency RMS Acceleration=%.3f G",
-		sensor_value_to_double(&meas->x_acc_rms_hf));
+	const struct qm30vt2_metric *metric = &metrics[idx];
+
+	return (float)*metric_value(metric, meas) / metric->div;
+}
+
+void qm30vt2_log_measurements(uint8_t unit_id, const struct qm30vt2_measurement *meas,
+			      uint32_t mask)
+{
+	char line[QM30VT2_LOG_LINE_LEN];
+	char num[APP_FIXED_STR_LEN];
+	size_t len = 0;
+
+	line[0] = '\0';
+
+	for (size_t i = 0; (i < ARRAY_SIZE(metrics)) && (len < sizeof(line)); i++) {
+		const struct qm30vt2_metric *metric = &metrics[i];
+
+		if (!(mask & BIT(i))) {
+			continue;
+		}
+
+		app_fixed_format(num, sizeof(num), *metric_value(metric, meas), metric->decimals);
+		len += snprintk(&line[len], sizeof(line) - len, "%s%s=%s", len ? " " : "",
+				metric->key, num);
+	}
+
+	LOG_DBG("QM30VT2 unit %u: %s", unit_id, line);
 }
@@ -7,84 +7,228 @@
 #ifndef __QM30VT2_H__
 #define __QM30VT2_H__
 
-#include <zephyr/drivers/sensor.h>
-
-/* QM30VT2 Modbus Register Alias Indexes */
-#define QM30VT2_Z_VEL_RMS_IN  0U
-#define QM30VT2_Z_VEL_RMS_MM  1U
-#define QM30VT2_TEMP_F	      2U
-#define QM30VT2_TEMP_C	      3U
-#define QM30VT2_X_VEL_RMS_IN  4U
-#define QM30VT2_X_VEL_RMS_MM  5U
-#define QM30VT2_Z_ACC_PEAK    6U
-#define QM30VT2_X_ACC_PEAK    7U
-#define QM30VT2_Z_VEL_FREQ    8U
-#define QM30VT2_X_VEL_FREQ    9U
-#define QM30VT2_Z_ACC_RMS     10U
-#define QM30VT2_X_ACC_RMS     11U
-#define QM30VT2_Z_ACC_KURT    12U
-#define QM30VT2_X_ACC_KURT    13U
-#define QM30VT2_Z_ACC_CF      14U
-#define QM30VT2_X_ACC_CF      15U
-#define QM30VT2_Z_VEL_PEAK_IN 16U
-#define QM30VT2_Z_VEL_PEAK_MM 17U
-#define QM30VT2_X_VEL_PEAK_IN 18U
-#define QM30VT2_X_VEL_PEAK_MM 19U
-#define QM30VT2_Z_ACC_RMS_HF  20U
-#define QM30VT2_X_ACC_RMS_HF  21U
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+/*
+ * QM30VT2 metrics, one per register of the alias block, in the order they appear
+ * in a stream record. Each X(name, NAME, idx, dec, sgn, qty, label, desc, path...)
+ * entry gives:
+ *
+ * - name:  member of struct qm30vt2_measurement
+ * - NAME:  suffix of the QM30VT2_<NAME> register index and Ostentus slide key
+ * - idx:   register index in the alias block (45201 + idx)
+ * - dec:   decimals of the register, which holds the value in the unit of qty × 10^dec
+ * - sgn:   the register holds a signed value
+ * - qty:   physical quantity, see enum qm30vt2_quantity
+ * - label: Ostentus slide label
+ * - desc:  description used in logs
+ * - path:  path of the value in a stream record
+ *
+ * Metrics sharing a parent path must be adjacent.
+ */
+/* clang-format off */
+#define QM30VT2_METRICS(X)                                                                         \
+	X(temp_c,          TEMP_C,         3, 2, true,  TEMP_C,  "Temperature", "Temperature",     \
+	  "temperature", "celcius")                                                                \
+	X(temp_f,          TEMP_F,         2, 2, true,  TEMP_F,  "Temperature", "Temperature",     \
+	  "temperature", "farenheight")                                                            \
+	X(x_acc_cf,        X_ACC_CF,      15, 3, false, RATIO,   "X CF", "X-Axis Crest Factor",    \
+	  "x_axis", "acceleration", "crest_factor")                                                \
+	X(x_acc_rms_hf,    X_ACC_RMS_HF,  21, 3, false, ACC_G,   "X RMS HF A",                     \
+	  "X-Axis High-Frequency RMS Acceleration",                                                \
+	  "x_axis", "acceleration", "high_frequency_rms")                                          \
+	X(x_acc_kurt,      X_ACC_KURT,    13, 3, false, RATIO,   "X Kurt", "X-Axis Kurtosis",      \
+	  "x_axis", "acceleration", "kurtosis")                                                    \
+	X(x_acc_peak,      X_ACC_PEAK,     7, 3, false, ACC_G,   "X Peak A",                       \
+	  "X-Axis Peak Acceleration", "x_axis", "acceleration", "peak")                            \
+	X(x_acc_rms,       X_ACC_RMS,     11, 3, false, ACC_G,   "X RMS A",                        \
+	  "X-Axis RMS Acceleration", "x_axis", "acceleration", "rms")                              \
+	X(x_vel_peak_freq, X_VEL_FREQ,     9, 1, false, FREQ_HZ, "X Peak F",                       \
+	  "X-Axis Peak Velocity Component Frequency", "x_axis", "velocity", "peak", "frequency")   \
+	X(x_vel_peak_in,   X_VEL_PEAK_IN, 18, 4, false, VEL_IN,  "X Peak Vel",                     \
+	  "X-Axis Peak Velocity", "x_axis", "velocity", "peak", "in_per_sec")                      \
+	X(x_vel_peak_mm,   X_VEL_PEAK_MM, 19, 3, false, VEL_MM,  "X Peak Vel",                     \
+	  "X-Axis Peak Velocity", "x_axis", "velocity", "peak", "mm_per_sec")                      \
+	X(x_vel_rms_in,    X_VEL_RMS_IN,   4, 4, false, VEL_IN,  "X RMS V",                        \
+	  "X-Axis RMS Velocity", "x_axis", "velocity", "rms", "in_per_sec")                        \
+	X(x_vel_rms_mm,    X_VEL_RMS_MM,   5, 3, false, VEL_MM,  "X RMS V",                        \
+	  "X-Axis RMS Velocity", "x_axis", "velocity", "rms", "mm_per_sec")                        \
+	X(z_acc_cf,        Z_ACC_CF,      14, 3, false, RATIO,   "Z CF", "Z-Axis Crest Factor",    \
+	  "z_axis", "acceleration", "crest_factor")                                                \
+	X(z_acc_rms_hf,    Z_ACC_RMS_HF,  20, 3, false, ACC_G,   "Z RMS HF A",                     \
+	  "Z-Axis High-Frequency RMS Acceleration",                                                \
+	  "z_axis", "acceleration", "high_frequency_rms")                                          \
+	X(z_acc_kurt,      Z_ACC_KURT,    12, 3, false, RATIO,   "Z Kurt", "Z-Axis Kurtosis",      \
+	  "z_axis", "acceleration", "kurtosis")                                                    \
+	X(z_acc_peak,      Z_ACC_PEAK,     6, 3, false, ACC_G,   "Z Peak A",                       \
+	  "Z-Axis Peak Acceleration", "z_axis", "acceleration", "peak")                            \
+	X(z_acc_rms,       Z_ACC_RMS,     10, 3, false, ACC_G,   "Z RMS A",                        \
+	  "Z-Axis RMS Acceleration", "z_axis", "acceleration", "rms")                              \
+	X(z_vel_peak_freq, Z_VEL_FREQ,     8, 1, false, FREQ_HZ, "Z Peak F",                       \
+	  "Z-Axis Peak Velocity Component Frequency", "z_axis", "velocity", "peak", "frequency")   \
+	X(z_vel_peak_in,   Z_VEL_PEAK_IN, 16, 4, false, VEL_IN,  "Z Peak Vel",                     \
+	  "Z-Axis Peak Velocity", "z_axis", "velocity", "peak", "in_per_sec")                      \
+	X(z_vel_peak_mm,   Z_VEL_PEAK_MM, 17, 3, false, VEL_MM,  "Z Peak Vel",                     \
+	  "Z-Axis Peak Velocity", "z_axis", "velocity", "peak", "mm_per_sec")                      \
+	X(z_vel_rms_in,    Z_VEL_RMS_IN,   0, 4, false, VEL_IN,  "Z RMS V",                        \
+	  "Z-Axis RMS Velocity", "z_axis", "velocity", "rms", "in_per_sec")                        \
+	X(z_vel_rms_mm,    Z_VEL_RMS_MM,   1, 3, false, VEL_MM,  "Z RMS V",                        \
+	  "Z-Axis RMS Velocity", "z_axis", "velocity", "rms", "mm_per_sec")
+/* clang-format on */
+
+enum qm30vt2_quantity {
+	QM30VT2_QTY_TEMP_C,
+	QM30VT2_QTY_TEMP_F,
+	/* Acceleration in G */
+	QM30VT2_QTY_ACC_G,
+	QM30VT2_QTY_VEL_IN,
+	QM30VT2_QTY_VEL_MM,
+	QM30VT2_QTY_FREQ_HZ,
+	/* Unitless, e.g. kurtosis and crest factor */
+	QM30VT2_QTY_RATIO,
+	QM30VT2_QTY_COUNT,
+};
 
 /* QM30VT2 Modbus Register Alias Addresses */
-#define QM30VT2_ALIAS_BASE_ADDR	    5200U /* 45201 */
-#define QM30VT2_ALIAS_SIZE	    22U
-#define QM30VT2_ALIAS_Z_VEL_RMS_IN  QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_VEL_RMS_IN  /* 45201 */
-#define QM30VT2_ALIAS_Z_VEL_RMS_MM  QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_VEL_RMS_IN  /* 45202 */
-#define QM30VT2_ALIAS_TEMP_F	    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_TEMP_F	    /* 45203 */
-#define QM30VT2_ALIAS_TEMP_C	    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_TEMP_C	    /* 45204 */
-#define QM30VT2_ALIAS_X_VEL_RMS_IN  QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_VEL_RMS_IN  /* 45205 */
-#define QM30VT2_ALIAS_X_VEL_RMS_MM  QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_VEL_RMS_MM  /* 45206 */
-#define QM30VT2_ALIAS_Z_ACC_PEAK    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_ACC_PEAK    /* 45207 */
-#define QM30VT2_ALIAS_X_ACC_PEAK    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_ACC_PEAK    /* 45208 */
-#define QM30VT2_ALIAS_Z_VEL_FREQ    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_VEL_FREQ    /* 45209 */
-#define QM30VT2_ALIAS_X_VEL_FREQ    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_VEL_FREQ    /* 45210 */
-#define QM30VT2_ALIAS_Z_ACC_RMS	    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_ACC_RMS	    /* 45211 */
-#define QM30VT2_ALIAS_X_ACC_RMS	    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_ACC_RMS	    /* 45212 */
-#define QM30VT2_ALIAS_Z_ACC_KURT    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_ACC_KURT    /* 45213 */
-#define QM30VT2_ALIAS_X_ACC_KURT    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_ACC_KURT    /* 45214 */
-#define QM30VT2_ALIAS_Z_ACC_CF	    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_ACC_CF	    /* 45215 */
-#define QM30VT2_ALIAS_X_ACC_CF	    QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_ACC_CF	    /* 45216 */
-#define QM30VT2_ALIAS_Z_VEL_PEAK_IN QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_VEL_PEAK_IN /* 45217 */
-#define QM30VT2_ALIAS_Z_VEL_PEAK_MM QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_VEL_PEAK_MM /* 45218 */
-#define QM30VT2_ALIAS_X_VEL_PEAK_IN QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_VEL_PEAK_IN /* 45219 */
-#define QM30VT2_ALIAS_X_VEL_PEAK_MM QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_VEL_PEAK_MM /* 45220 */
-#define QM30VT2_ALIAS_Z_ACC_RMS_HF  QM30VT2_ALIAS_BASE_ADDR + QM30VT2_Z_ACC_RMS_HF  /* 45221 */
-#define QM30VT2_ALIAS_X_ACC_RMS_HF  QM30VT2_ALIAS_BASE_ADDR + QM30VT2_X_ACC_RMS_HF  /* 45222 */
+#define QM30VT2_ALIAS_BASE_ADDR 5200U /* 45201 */
+#define QM30VT2_ALIAS_SIZE	22U
+
+/* Most registers a single FC03 request can read */
+#define QM30VT2_READ_MAX_REGS 125U
+
+#define QM30VT2_X_REG(name, NAME, idx, ...)                                                        \
+	QM30VT2_##NAME = (idx), QM30VT2_ALIAS_##NAME = QM30VT2_ALIAS_BASE_ADDR + (idx),
+
+/* QM30VT2 Modbus Register Alias Indexes and Addresses */
+enum {
+	QM30VT2_METRICS(QM30VT2_X_REG)
+};
+
+#define QM30VT2_X_MEMBER(name, ...) int32_t name;
 
+/* Members are in stream record order, see QM30VT2_METRICS. Each holds the value of
+ * its register as fixed-point with the decimals of the metric (see app_fixed.h),
+ * e.g. 512 for 0.0512 in/sec.
+ */
 struct qm30vt2_measurement {
-	struct sensor_value temp_f;
-	struct sensor_value temp_c;
-	struct sensor_value z_vel_rms_in;
-	struct sensor_value z_vel_rms_mm;
-	struct sensor_value x_vel_rms_in;
-	struct sensor_value x_vel_rms_mm;
-	struct sensor_value z_acc_peak;
-	struct sensor_value x_acc_peak;
-	struct sensor_value z_vel_peak_freq;
-	struct sensor_value x_vel_peak_freq;
-	struct sensor_value z_acc_rms;
-	struct sensor_value x_acc_rms;
-	struct sensor_value z_acc_kurt;
-	struct sensor_value x_acc_kurt;
-	struct sensor_value z_acc_cf;
-	struct sensor_value x_acc_cf;
-	struct sensor_value z_vel_peak_in;
-	struct sensor_value z_vel_peak_mm;
-	struct sensor_value x_vel_peak_in;
-	struct sensor_value x_vel_peak_mm;
-	struct sensor_value z_acc_rms_hf;
-	struct sensor_value x_acc_rms_hf;
+	QM30VT2_METRICS(QM30VT2_X_MEMBER)
+#ifdef CONFIG_APP_QM30VT2_EXT
+	/* Raw values of the CONFIG_APP_QM30VT2_EXT_REGS registers, in that order */
+	uint16_t ext_reg[CONFIG_APP_QM30VT2_EXT_REGS_MAX];
+#endif
+};
+
+#define QM30VT2_X_COUNT(...) +1
+
+#define QM30VT2_METRIC_COUNT (0 QM30VT2_METRICS(QM30VT2_X_COUNT))
+
+BUILD_ASSERT(QM30VT2_METRIC_COUNT == QM30VT2_ALIAS_SIZE, "One metric per alias register");
+
+#define QM30VT2_X_INDEX(name, NAME, ...) QM30VT2_METRIC_##NAME,
+
+/* Position of each metric in QM30VT2_METRICS, which is its bit in a metric mask */
+enum {
+	QM30VT2_METRICS(QM30VT2_X_INDEX)
+};
+
+BUILD_ASSERT(QM30VT2_METRIC_COUNT <= 32, "Metric mask must fit in 32 bits");
+
+#define QM30VT2_METRICS_ALL BIT_MASK(QM30VT2_METRIC_COUNT)
+
+/**
+ * Format metric idx (in QM30VT2_METRICS order) of a measurement with its unit,
+ * e.g. "0.0512 in/sec", using integer arithmetic only. Returns the snprintk()
+ * result.
+ */
+int qm30vt2_metric_format(char *buf, size_t len, const struct qm30vt2_measurement *meas,
+			  size_t idx);
+
+/**
+ * Value of metric idx (in QM30VT2_METRICS order) of a measurement in the unit of
+ * its quantity, for code that works in float such as alarm thresholds.
+ */
+float qm30vt2_metric_float(const struct qm30vt2_measurement *meas, size_t idx);
+
+/**
+ * Smallest contiguous span of alias registers holding the metrics in a mask.
+ *
+ * @param first set to the index of the first register of the span
+ *
+ * @return the number of registers in the span, 0 if the mask is empty
+ */
+uint16_t qm30vt2_reg_span(uint32_t mask, uint16_t *first);
+
+/* A register to read and where its value goes */
+struct qm30vt2_reg_req {
+	uint16_t addr;
+	uint16_t *dst;
+};
+
+/* One FC03 transaction of a read plan */
+struct qm30vt2_xfer {
+	uint16_t addr;
+	uint16_t count;
 };
 
-int qm30vt2_read_data(const int iface, uint8_t unit_id, struct qm30vt2_measurement *meas);
-void qm30vt2_log_measurements(struct qm30vt2_measurement *meas);
+/**
+ * Plan the FC03 transactions that read a set of registers. Neighbouring
+ * registers are coalesced into one transaction, which also reads the registers
+ * in between, as long as the gap is at most gap_max registers and the
+ * transaction at most QM30VT2_READ_MAX_REGS. Reading a gap register costs two
+ * bytes on the wire, a transaction costs its request, response framing and the
+ * response latency of the sensor.
+ *
+ * @param reqs registers in ascending address order
+ *
+ * @return the number of transactions, -ENOMEM if more than max_xfers are needed
+ */
+int qm30vt2_read_plan(const struct qm30vt2_reg_req *reqs, size_t count, uint16_t gap_max,
+		      struct qm30vt2_xfer *xfers, size_t max_xfers);
+
+/**
+ * Run the transactions of a read plan and scatter the values read to the
+ * destinations of reqs. Stops at the first failed transaction.
+ */
+int qm30vt2_read_planned(const int iface, uint8_t unit_id, const struct qm30vt2_xfer *xfers,
+			 size_t xfer_count, const struct qm30vt2_reg_req *reqs, size_t count);
+
+/**
+ * Read the registers of the metrics in a mask from a sensor, along with the
+ * CONFIG_APP_QM30VT2_EXT_REGS registers into meas->ext_reg when enabled, in
+ * as few transactions as qm30vt2_read_plan() allows. holding_reg is indexed
+ * like the whole alias block (QM30VT2_ALIAS_SIZE registers); registers of
+ * other metrics are left untouched.
+ */
+int qm30vt2_read_regs(const int iface, uint8_t unit_id, uint16_t *holding_reg, uint32_t mask,
+		      struct qm30vt2_measurement *meas);
+
+/** Number of CONFIG_APP_QM30VT2_EXT_REGS registers read with each measurement. */
+size_t qm30vt2_ext_count(void);
+
+/**
+ * Parse CONFIG_APP_QM30VT2_EXT_REGS, before the first read. If the list is
+ * invalid, -EINVAL is returned and no extended registers are read.
+ */
+int qm30vt2_init(void);
+
+/**
+ * Copy the registers of the metrics in a mask into a measurement, sign extending
+ * signed registers. Other metrics are cleared without reading their registers. Extended registers
+ * are left untouched.
+ */
+int qm30vt2_decode(const uint16_t *holding_reg, struct qm30vt2_measurement *meas, uint32_t mask);
+
+int qm30vt2_read_data(const int iface, uint8_t unit_id, struct qm30vt2_measurement *meas,
+		      uint32_t mask);
+
+/**
+ * Log the metrics of a measurement in a mask as a single debug line of name=value
+ * pairs, e.g. "QM30VT2 unit 1: temp_c=23.45 temp_f=74.21 ...". Names are the
+ * fields of struct qm30vt2_measurement, units follow from the name.
+ */
+void qm30vt2_log_measurements(uint8_t unit_id, const struct qm30vt2_measurement *meas,
+			      uint32_t mask);
 
 #endif /* __QM30VT2_H__ */
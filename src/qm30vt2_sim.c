@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(qm30vt2_sim, LOG_LEVEL_INF);
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+
+#include "qm30vt2_sim.h"
+
+#define MODBUS_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(zephyr_modbus_serial)
+
+/* Unit ID, function, start address, register count and CRC */
+#define SIM_REQ_LEN 8
+/* Unit ID, function, byte count, registers and CRC */
+#define SIM_RSP_MAX_LEN (5 + 2 * QM30VT2_ALIAS_SIZE)
+
+#define SIM_FC_READ_HOLDING_REGS 0x03
+#define SIM_EXC_ILLEGAL_FUNCTION 0x01
+#define SIM_EXC_ILLEGAL_ADDRESS	 0x02
+
+static const struct device *const uart_dev = DEVICE_DT_GET(DT_PARENT(MODBUS_NODE));
+
+/* A machine in good condition, ISO 10816 zone A */
+static uint16_t sim_regs[QM30VT2_ALIAS_SIZE] = {
+	[QM30VT2_Z_VEL_RMS_IN] = 512,	 /* 0.0512 in/s */
+	[QM30VT2_Z_VEL_RMS_MM] = 1300,	 /* 1.300 mm/s */
+	[QM30VT2_TEMP_F] = 7250,	 /* 72.50 °F */
+	[QM30VT2_TEMP_C] = 2250,	 /* 22.50 °C */
+	[QM30VT2_X_VEL_RMS_IN] = 433,	 /* 0.0433 in/s */
+	[QM30VT2_X_VEL_RMS_MM] = 1100,	 /* 1.100 mm/s */
+	[QM30VT2_Z_ACC_PEAK] = 250,	 /* 0.250 G */
+	[QM30VT2_X_ACC_PEAK] = 220,	 /* 0.220 G */
+	[QM30VT2_Z_VEL_FREQ] = 295,	 /* 29.5 Hz */
+	[QM30VT2_X_VEL_FREQ] = 295,	 /* 29.5 Hz */
+	[QM30VT2_Z_ACC_RMS] = 80,	 /* 0.080 G */
+	[QM30VT2_X_ACC_RMS] = 70,	 /* 0.070 G */
+	[QM30VT2_Z_ACC_KURT] = 3000,	 /* 3.000 */
+	[QM30VT2_X_ACC_KURT] = 3100,	 /* 3.100 */
+	[QM30VT2_Z_ACC_CF] = 3100,	 /* 3.100 */
+	[QM30VT2_X_ACC_CF] = 3200,	 /* 3.200 */
+	[QM30VT2_Z_VEL_PEAK_IN] = 724,	 /* 0.0724 in/s */
+	[QM30VT2_Z_VEL_PEAK_MM] = 1839, /* 1.839 mm/s */
+	[QM30VT2_X_VEL_PEAK_IN] = 612,	 /* 0.0612 in/s */
+	[QM30VT2_X_VEL_PEAK_MM] = 1554, /* 1.554 mm/s */
+	[QM30VT2_Z_ACC_RMS_HF] = 40,	 /* 0.040 G */
+	[QM30VT2_X_ACC_RMS_HF] = 35,	 /* 0.035 G */
+};
+
+static struct qm30vt2_sim_config sim_cfg = {
+	.latency_ms = CONFIG_APP_QM30VT2_SIM_LATENCY_MS,
+	.timeout_pct = CONFIG_APP_QM30VT2_SIM_TIMEOUT_PCT,
+	.crc_error_pct = CONFIG_APP_QM30VT2_SIM_CRC_ERROR_PCT,
+	.dead_unit = CONFIG_APP_QM30VT2_SIM_DEAD_UNIT,
+	.noise_pct = CONFIG_APP_QM30VT2_SIM_NOISE_PCT,
+};
+
+static struct qm30vt2_sim_stats sim_stats;
+static struct k_spinlock sim_lock;
+
+static uint8_t req[SIM_REQ_LEN];
+static size_t req_len;
+static uint8_t rsp[SIM_RSP_MAX_LEN];
+static size_t rsp_len;
+
+/* Fixed seed so benchmark runs are reproducible */
+static uint32_t rand_state = 0x51564d52;
+
+static uint32_t sim_rand(void)
+{
+	/* xorshift32 */
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+
+	return rand_state;
+}
+
+static bool sim_chance(uint8_t pct)
+{
+	return (sim_rand() % 100) < pct;
+}
+
+static uint16_t sim_reg_value(size_t idx, uint8_t noise_pct)
+{
+	int32_t val = sim_regs[idx];
+
+	/* Temperatures are signed and drift too slowly for noise to matter */
+	if ((idx == QM30VT2_TEMP_F) || (idx == QM30VT2_TEMP_C) || (noise_pct == 0)) {
+		return val;
+	}
+
+	val += ((int32_t)(sim_rand() % (2 * noise_pct + 1)) - noise_pct) * val / 100;
+
+	return CLAMP(val, 0, UINT16_MAX);
+}
+
+/* Time to send one character, including start, parity and stop bits */
+static uint32_t sim_char_us(void)
+{
+	struct uart_config cfg;
+	uint32_t bits = 10;
+
+	if (uart_config_get(uart_dev, &cfg) != 0) {
+		return 10 * USEC_PER_SEC / 19200;
+	}
+
+	if (cfg.parity != UART_CFG_PARITY_NONE) {
+		bits++;
+	}
+	if (cfg.stop_bits == UART_CFG_STOP_BITS_2) {
+		bits++;
+	}
+
+	return bits * USEC_PER_SEC / cfg.baudrate;
+}
+
+static void rsp_work_handler(struct k_work *work)
+{
+	uart_emul_put_rx_data(uart_dev, rsp, rsp_len);
+
+	K_SPINLOCK(&sim_lock) {
+		sim_stats.responses++;
+	}
+}
+static K_WORK_DELAYABLE_DEFINE(rsp_work, rsp_work_handler);
+
+static void sim_exception(uint8_t unit_id, uint8_t fc, uint8_t code)
+{
+	rsp[0] = unit_id;
+	rsp[1] = fc | 0x80;
+	rsp[2] = code;
+	rsp_len = 3;
+
+	sim_stats.exceptions++;
+}
+
+/* Build the response to the request in req, returns false to stay silent */
+static bool sim_handle_request(void)
+{
+	uint8_t unit_id = req[0];
+	uint8_t fc = req[1];
+	uint16_t addr = sys_get_be16(&req[2]);
+	uint16_t count = sys_get_be16(&req[4]);
+	uint16_t crc;
+	bool respond = true;
+
+	/* Like a real device, frames with a bad CRC are ignored */
+	if (crc16_ansi(req, SIM_REQ_LEN - 2) != sys_get_le16(&req[SIM_REQ_LEN - 2])) {
+		LOG_WRN("Request with bad CRC ignored");
+		return false;
+	}
+
+	K_SPINLOCK(&sim_lock) {
+		sim_stats.requests++;
+
+		/* Broadcasts are never answered, nor is the simulated unplugged unit */
+		if ((unit_id == 0) || (unit_id == sim_cfg.dead_unit)) {
+			respond = false;
+			K_SPINLOCK_BREAK;
+		}
+
+		if (sim_chance(sim_cfg.timeout_pct)) {
+			sim_stats.timeouts++;
+			respond = false;
+			K_SPINLOCK_BREAK;
+		}
+
+		if (fc != SIM_FC_READ_HOLDING_REGS) {
+			sim_exception(unit_id, fc, SIM_EXC_ILLEGAL_FUNCTION);
+		} else if ((count == 0) || (addr < QM30VT2_ALIAS_BASE_ADDR) ||
+			   (addr + count > QM30VT2_ALIAS_BASE_ADDR + QM30VT2_ALIAS_SIZE)) {
+			sim_exception(unit_id, fc, SIM_EXC_ILLEGAL_ADDRESS);
+		} else {
+			rsp[0] = unit_id;
+			rsp[1] = fc;
+			rsp[2] = 2 * count;
+			rsp_len = 3;
+
+			for (size_t i = 0; i < count; i++) {
+				sys_put_be16(sim_reg_value(addr - QM30VT2_ALIAS_BASE_ADDR + i,
+							   sim_cfg.noise_pct),
+					     &rsp[rsp_len]);
+				rsp_len += 2;
+			}
+		}
+
+		crc = crc16_ansi(rsp, rsp_len);
+		if (sim_chance(sim_cfg.crc_error_pct)) {
+			crc ^= 0x0001;
+			sim_stats.crc_errors++;
+		}
+		sys_put_le16(crc, &rsp[rsp_len]);
+		rsp_len += 2;
+	}
+
+	return respond;
+}
+
+static void sim_tx_ready(const struct device *dev, size_t size, void *user_data)
+{
+	uint32_t delay_us;
+
+	req_len += uart_emul_get_tx_data(dev, &req[req_len], sizeof(req) - req_len);
+	if (req_len < sizeof(req)) {
+		return;
+	}
+
+	/* The client only sends fixed length requests; anything longer is dropped */
+	req_len = 0;
+	uart_emul_flush_tx_data(dev);
+
+	if (!sim_handle_request()) {
+		return;
+	}
+
+	/* The request and response take time on the wire too */
+	delay_us = sim_cfg.latency_ms * USEC_PER_MSEC + (SIM_REQ_LEN + rsp_len) * sim_char_us();
+
+	k_work_reschedule(&rsp_work, K_USEC(delay_us));
+}
+
+void qm30vt2_sim_configure(const struct qm30vt2_sim_config *cfg)
+{
+	K_SPINLOCK(&sim_lock) {
+		sim_cfg = *cfg;
+		sim_cfg.timeout_pct = MIN(sim_cfg.timeout_pct, 100);
+		sim_cfg.crc_error_pct = MIN(sim_cfg.crc_error_pct, 100);
+	}
+}
+
+void qm30vt2_sim_config_get(struct qm30vt2_sim_config *cfg)
+{
+	K_SPINLOCK(&sim_lock) {
+		*cfg = sim_cfg;
+	}
+}
+
+void qm30vt2_sim_set_regs(const uint16_t *holding_reg)
+{
+	K_SPINLOCK(&sim_lock) {
+		memcpy(sim_regs, holding_reg, sizeof(sim_regs));
+	}
+}
+
+void qm30vt2_sim_stats_get(struct qm30vt2_sim_stats *stats)
+{
+	K_SPINLOCK(&sim_lock) {
+		*stats = sim_stats;
+	}
+}
+
+void qm30vt2_sim_stats_reset(void)
+{
+	K_SPINLOCK(&sim_lock) {
+		memset(&sim_stats, 0, sizeof(sim_stats));
+	}
+}
+
+static int qm30vt2_sim_init(void)
+{
+	if (!device_is_ready(uart_dev)) {
+		LOG_ERR("Emulated UART for the simulated QM30VT2 is not ready");
+		return -ENODEV;
+	}
+
+	uart_emul_callback_tx_data_ready_set(uart_dev, sim_tx_ready, NULL);
+
+	LOG_INF("Simulated QM30VT2 on %s, %u ms latency, %u%% timeouts, %u%% CRC errors",
+		uart_dev->name, sim_cfg.latency_ms, sim_cfg.timeout_pct, sim_cfg.crc_error_pct);
+
+	return 0;
+}
+
+SYS_INIT(qm30vt2_sim_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __QM30VT2_SIM_H__
+#define __QM30VT2_SIM_H__
+
+/** Simulated QM30VT2 Modbus RTU server for builds without a sensor.
+ *
+ * The server sits on the far side of the emulated UART (`zephyr,uart-emul`)
+ * that carries the Modbus client, so the real client, serial driver and
+ * qm30vt2.c code paths are exercised. It answers FC03 reads of the alias
+ * register block at 45201+ for every unit ID, with configurable register
+ * values, response latency and injected timeouts and CRC errors. One unit ID
+ * can be left unanswered to simulate an unplugged sensor. Requests for other
+ * functions or registers get Modbus exception responses.
+ */
+
+#include <stdint.h>
+
+#include "qm30vt2.h"
+
+struct qm30vt2_sim_config {
+	/* Delay before a response is sent, on top of its time on the wire */
+	uint32_t latency_ms;
+	/* Percentage of requests that are not answered */
+	uint8_t timeout_pct;
+	/* Percentage of responses sent with a corrupted CRC */
+	uint8_t crc_error_pct;
+	/* Unit ID whose requests are never answered, 0 for none */
+	uint8_t dead_unit;
+	/* Random variation applied to each register value, in percent */
+	uint8_t noise_pct;
+};
+
+struct qm30vt2_sim_stats {
+	uint32_t requests;
+	uint32_t responses;
+	uint32_t timeouts;
+	uint32_t crc_errors;
+	uint32_t exceptions;
+};
+
+void qm30vt2_sim_configure(const struct qm30vt2_sim_config *cfg);
+void qm30vt2_sim_config_get(struct qm30vt2_sim_config *cfg);
+
+/** Set the alias register block (QM30VT2_ALIAS_SIZE values) served to all units. */
+void qm30vt2_sim_set_regs(const uint16_t *holding_reg);
+
+void qm30vt2_sim_stats_get(struct qm30vt2_sim_stats *stats);
+void qm30vt2_sim_stats_reset(void);
+
+#endif /* __QM30VT2_SIM_H__ */